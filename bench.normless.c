@@ -0,0 +1,482 @@
+// Kernel micro-benchmarks. Build next to main.normless.c and run from the repository root:
+//   gcc -O2 bench.normless.c -o bench.normless $(sdl2-config --cflags --libs) -lm
+// Every result is printed as one JSON object per line, timings are in nanoseconds per operation.
+// Cache misses per operation come from perf_event_open and are null when the kernel does not expose the counters.
+
+#define RAYCAST_NO_MAIN
+#include "main.normless.c"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#define BENCH_WARMUP 3
+#define BENCH_SAMPLES 15
+#define BENCH_TEXTURE_SIZE 64
+#define BENCH_WALLS 64
+
+typedef void (*t_bench_kernel)(t_sdl_master *master, int iteration);
+
+typedef struct
+{
+	t_vec2 position;
+	float angle;
+} t_bench_start;
+
+typedef struct
+{
+	Uint8 *pixels;
+	t_bench_start walls[BENCH_WALLS];
+	char ppm_path[64];
+	int l1d_misses;
+	int cache_misses;
+	volatile Uint32 sink;
+} t_bench;
+
+t_bench bench;
+
+double bench_now(void)
+{
+	return SDL_GetPerformanceCounter() * 1000000000.0 / SDL_GetPerformanceFrequency();
+}
+
+int bench_counter_open(Uint32 type, Uint64 config)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = type;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void bench_counter_print(const char *name, int fd, double operations)
+{
+	Uint64 value = 0;
+	if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value))
+		printf(", \"%s\": null", name);
+	else
+		printf(", \"%s\": %.3f", name, value / operations);
+}
+
+int bench_compare(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+void bench_run(t_sdl_master *master, const char *kernel, const char *map, double density,
+	t_bench_kernel function, int iterations, int operations)
+{
+	double samples[BENCH_SAMPLES];
+	for (int i = 0; i < BENCH_WARMUP * iterations; i++)
+	{
+		function(master, i);
+	}
+	int counters[] = {bench.l1d_misses, bench.cache_misses};
+	for (int i = 0; i < 2; i++)
+	{
+		if (counters[i] != -1)
+		{
+			ioctl(counters[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(counters[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+	for (int sample = 0; sample < BENCH_SAMPLES; sample++)
+	{
+		double start = bench_now();
+		for (int i = 0; i < iterations; i++)
+		{
+			function(master, i);
+		}
+		samples[sample] = (bench_now() - start) / ((double) iterations * operations);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (counters[i] != -1)
+			ioctl(counters[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+	qsort(samples, BENCH_SAMPLES, sizeof(double), bench_compare);
+	double mean = 0;
+	for (int i = 0; i < BENCH_SAMPLES; i++)
+		mean += samples[i] / BENCH_SAMPLES;
+	double variance = 0;
+	for (int i = 0; i < BENCH_SAMPLES; i++)
+		variance += (samples[i] - mean) * (samples[i] - mean) / BENCH_SAMPLES;
+	printf("{\"kernel\": \"%s\", \"map\": \"%s\", \"density\": %.2f, \"iterations\": %d, \"samples\": %d, "
+		"\"ns_min\": %.3f, \"ns_median\": %.3f, \"ns_max\": %.3f, \"ns_mean\": %.3f, \"ns_stddev\": %.3f",
+		kernel, map, density, iterations * operations, BENCH_SAMPLES,
+		samples[0], samples[BENCH_SAMPLES / 2], samples[BENCH_SAMPLES - 1], mean, sqrt(variance));
+	bench_counter_print("l1d_misses", bench.l1d_misses, (double) BENCH_SAMPLES * iterations * operations);
+	bench_counter_print("cache_misses", bench.cache_misses, (double) BENCH_SAMPLES * iterations * operations);
+	printf("}\n");
+	fflush(stdout);
+}
+
+void bench_texture_get(t_sdl_master *master, int iteration)
+{
+	bench.sink += texture_get(master, "01"[iteration & 1]).size;
+}
+
+void bench_screen_draw_pixel(t_sdl_master *master, int iteration)
+{
+	screen_draw_pixel(&master->screen,
+		&(t_vec2){iteration * 7 % master->screen.width, iteration * 13 % master->screen.height},
+		&(t_color){255, 128, 0, 128});
+}
+
+void bench_screen_draw_line(t_sdl_master *master, int iteration)
+{
+	int x = iteration % master->screen.width;
+	screen_draw_line(&master->screen,
+		&(t_vec2){x, 0}, &(t_vec2){master->screen.width - 1 - x, master->screen.height - 1},
+		&(t_color){255, 128, 0, 128});
+}
+
+void bench_screen_draw_rect(t_sdl_master *master, int iteration)
+{
+	int x = iteration % (master->screen.width - 64);
+	screen_draw_rect(&master->screen,
+		&(t_vec2){x, 64}, &(t_vec2){x + 63, 127},
+		&(t_color){255, 128, 0, 128}, 1);
+}
+
+void bench_screen_draw_circle(t_sdl_master *master, int iteration)
+{
+	int x = 32 + iteration % (master->screen.width - 64);
+	screen_draw_circle(&master->screen,
+		&(t_vec2){x, master->screen.height / 2},
+		32, &(t_color){255, 128, 0, 128}, 1);
+}
+
+void bench_update_canvas(t_sdl_master *master, int iteration)
+{
+	(void) iteration;
+	update_canvas(SCREEN_WIDTH * SCREEN_HEIGHT * 4, SCREEN_WIDTH, &bench.pixels, &master->screen);
+}
+
+void bench_texture_parse(t_sdl_master *master, int iteration)
+{
+	(void) master;
+	(void) iteration;
+	t_texture texture = {.name = 'p', .is_solid = 1, .opacity = 255};
+	int fd = open(bench.ppm_path, O_RDONLY);
+	if (fd == -1)
+		return;
+	texture_parse(&texture, fd);
+	bench.sink += texture.array[0];
+	free(texture.array);
+}
+
+void bench_cast_rays(t_sdl_master *master, int iteration)
+{
+	master->player.direction = iteration * 2 * PI / 64;
+	cast_rays(master);
+}
+
+void bench_cast_rays_interlaced(t_sdl_master *master, int iteration)
+{
+	// Slow turn (about three columns per frame) so most columns can be reprojected.
+	master->player.direction = iteration * 2 * PI / 1024;
+	master->interlace.enabled = 1;
+	cast_rays(master);
+}
+
+void bench_frame(t_sdl_master *master, int iteration)
+{
+	// The same slow turn with the screen drawn, where interlaced frames reuse last frame's pixels.
+	master->player.direction = iteration * 2 * PI / 1024;
+	cast_rays(master);
+	update_screen(master);
+}
+
+void bench_frame_interlaced(t_sdl_master *master, int iteration)
+{
+	master->interlace.enabled = 1;
+	bench_frame(master, iteration);
+}
+
+void bench_cast_rays_fixed(t_sdl_master *master, int iteration)
+{
+	master->player.fixed_direction = iteration * (FIXED_ANGLES / 64) % FIXED_ANGLES;
+	cast_rays_fixed(master);
+}
+
+void bench_roam(t_sdl_master *master, int iteration)
+{
+	// Starts every cast from a different open cell so the large map benchmarks are not served from a warm cache.
+	Uint32 seed = (Uint32) iteration * 2654435761u + 1;
+	int x, y;
+	do
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		x = 1 + seed % (master->level.width - 2);
+		y = 1 + (seed >> 12) % (master->level.height - 2);
+	} while (level_bit(master->level.wall, level_index(&master->level, x, y)));
+	master->player.position = (t_vec2){x + 0.5, y + 0.5};
+	master->player.direction = iteration * 2 * PI / 64;
+	fixed_sync(master);
+}
+
+void bench_cast_rays_roam(t_sdl_master *master, int iteration)
+{
+	bench_roam(master, iteration);
+	cast_rays(master);
+}
+
+void bench_cast_rays_fixed_roam(t_sdl_master *master, int iteration)
+{
+	bench_roam(master, iteration);
+	cast_rays_fixed(master);
+}
+
+void bench_draw_columns(t_sdl_master *master, int iteration)
+{
+	(void) iteration;
+	for (int i = 0; i < RAYS_AMOUNT; i++)
+	{
+		t_ray *ray = &master->player.rays[i];
+		t_texture texture = texture_get(master, ray->texture);
+		t_column column;
+		if (texture.size > 0 && screen_column(master, ray, texture.size, &column))
+			screen_draw_column(master, i, &texture, &column);
+	}
+}
+
+void bench_draw_surfaces(t_sdl_master *master, int iteration)
+{
+	(void) iteration;
+	screen_draw_surfaces(master);
+}
+
+void bench_update_screen(t_sdl_master *master, int iteration)
+{
+	(void) iteration;
+	update_screen(master);
+}
+
+void bench_handle_collisions(t_sdl_master *master, int iteration)
+{
+	t_bench_start *start = &bench.walls[iteration % BENCH_WALLS];
+	t_vec2 back = start->position;
+	t_vec2 direction = {0.06 * cos(start->angle), 0.06 * sin(start->angle)};
+	bench.sink += handle_collisions(master, 0,
+		(t_vec2){back.x + direction.x, back.y + direction.y}, back, direction);
+}
+
+void bench_handle_collisions_fixed(t_sdl_master *master, int iteration)
+{
+	t_bench_start *start = &bench.walls[iteration % BENCH_WALLS];
+	t_fixed_vec2 back = {(t_fixed) (start->position.x * FIXED_ONE), (t_fixed) (start->position.y * FIXED_ONE)};
+	int angle = (int) (start->angle * FIXED_ANGLES / (2 * PI) + FIXED_ANGLES + 0.5) % FIXED_ANGLES;
+	t_fixed_vec2 direction = {
+		(Sint64) master->player.fixed_speed * fixed_cos(master, angle) >> FIXED_SHIFT,
+		(Sint64) master->player.fixed_speed * master->fixed.sin[angle] >> FIXED_SHIFT};
+	bench.sink += handle_collisions_fixed(master, 0,
+		(t_fixed_vec2){back.x + direction.x, back.y + direction.y}, back, direction);
+}
+
+void bench_level_free(t_sdl_master *master)
+{
+	free(master->level.array);
+	free(master->level.floor);
+	free(master->level.ceiling);
+	free(master->level.light);
+	free(master->level.wall);
+	free(master->level.solid);
+	free(master->level.transparent);
+	free(master->level.thin);
+	free(master->level.names);
+	free(master->level.door);
+}
+
+void bench_walls(t_sdl_master *master)
+{
+	// Collision starts sit 0.22 cells short of a wall face, so a 0.06 step toward it always reaches the 0.2 margin.
+	Uint32 seed = 88172645u;
+	int found = 0;
+	while (found < BENCH_WALLS)
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		int x = 1 + seed % (master->level.width - 2);
+		int y = 1 + (seed >> 12) % (master->level.height - 2);
+		int side = (seed >> 24) % 4;
+		int dx = (int[]){1, 0, -1, 0}[side];
+		int dy = (int[]){0, 1, 0, -1}[side];
+		if (level_bit(master->level.wall, level_index(&master->level, x, y))
+			|| !level_bit(master->level.solid, level_index(&master->level, x + dx, y + dy)))
+			continue;
+		float jitter = ((int) (seed >> 4) % 91 - 45) * PI / 180;
+		bench.walls[found++] = (t_bench_start){{x + 0.5 + 0.28 * dx, y + 0.5 + 0.28 * dy}, atan2(dy, dx) + jitter};
+	}
+}
+
+int bench_level(t_sdl_master *master, int size, double density, int tiled)
+{
+	if (level_init(master, size, size) != 0)
+		return 1;
+	Uint32 seed = 2463534242u;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			int border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+			int center = abs(x - size / 2) <= 1 && abs(y - size / 2) <= 1;
+			master->level.floor[level_index(&master->level, x, y)] = '1';
+			master->level.array[level_index(&master->level, x, y)] = border || (!center && seed % 1000 < density * 1000) ? '1' : '0';
+		}
+	}
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+			level_refresh(master, x, y);
+	lighting_compute(master);
+	if (level_layout(master, tiled) != 0)
+		return 1;
+	bench_walls(master);
+	master->player.position = (t_vec2){size / 2 + 0.5, size / 2 + 0.5};
+	master->player.direction = 0;
+	fixed_sync(master);
+	return 0;
+}
+
+int bench_init(t_sdl_master *master)
+{
+	master->screen.width = SCREEN_WIDTH;
+	master->screen.height = SCREEN_HEIGHT;
+	master->screen.scale = 1;
+	master->screen.array = calloc(SCREEN_WIDTH * SCREEN_HEIGHT * 4, sizeof(Uint8));
+	master->interlace.pixels = calloc(SCREEN_WIDTH * SCREEN_HEIGHT * 4, sizeof(Uint8));
+	memset(master->interlace.reuse, -1, sizeof(master->interlace.reuse));
+	master->tiles.array = NULL;
+	master->textures.amount = 0;
+	master->textures.list = NULL;
+	memset(master->textures.lookup, 0, sizeof(master->textures.lookup));
+	master->textures.not_found = (t_texture){.name = '?', .is_solid = 1, .opacity = 255};
+	master->lighting.amount = 0;
+	master->player.speed = 0.06;
+	master->player.fixed_speed = (t_fixed) (0.06 * FIXED_ONE);
+	master->fixed_point = 0;
+	bench.l1d_misses = bench_counter_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+		| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	bench.cache_misses = bench_counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	bench.pixels = calloc(SCREEN_WIDTH * SCREEN_HEIGHT * 4, sizeof(Uint8));
+	Uint8 *array = malloc(BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 3 * sizeof(Uint8));
+	if (master->screen.array == NULL || master->interlace.pixels == NULL || bench.pixels == NULL || array == NULL)
+	{
+		printf("malloc Error.\n");
+		return 1;
+	}
+	for (int i = 0; i < BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 3; i++)
+		array[i] = (i / 3 % BENCH_TEXTURE_SIZE / 8 + i / 3 / BENCH_TEXTURE_SIZE / 8) % 2 ? 200 : 60;
+	texture_add(master, '0', 0, 0, NULL);
+	texture_add(master, '1', BENCH_TEXTURE_SIZE, 1, array);
+	lighting_add(master, (t_vec2){4.5, 4.5}, 6, 0.5);
+	fixed_compute(master);
+
+	strcpy(bench.ppm_path, "/tmp/raycasting-bench-XXXXXX");
+	int fd = mkstemp(bench.ppm_path);
+	if (fd == -1)
+	{
+		printf("mkstemp Error.\n");
+		return 1;
+	}
+	FILE *file = fdopen(fd, "w");
+	fprintf(file, "P3\n# is_solid 1\n%d %d\n255\n", BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE);
+	for (int i = 0; i < BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 3; i++)
+		fprintf(file, "%d\n", array[i]);
+	fclose(file);
+	return 0;
+}
+
+int bench_quit(int exit_code)
+{
+	if (bench.ppm_path[0] != '\0')
+		unlink(bench.ppm_path);
+	return exit_code;
+}
+
+int main()
+{
+	static t_sdl_master master;
+	int sizes[] = {16, 64, 256, 1024};
+	double densities[] = {0.05, 0.2, 0.4};
+	int layout_sizes[] = {4096, 8192};
+	double layout_densities[] = {0.02, 0.1};
+
+	if (bench_init(&master) != 0)
+		return bench_quit(1);
+
+	bench_run(&master, "texture_get", "-", 0, bench_texture_get, 1000000, 1);
+	bench_run(&master, "screen_draw_pixel", "-", 0, bench_screen_draw_pixel, 1000000, 1);
+	bench_run(&master, "screen_draw_line", "-", 0, bench_screen_draw_line, 2000, 1);
+	bench_run(&master, "screen_draw_rect", "-", 0, bench_screen_draw_rect, 500, 1);
+	bench_run(&master, "screen_draw_circle", "-", 0, bench_screen_draw_circle, 500, 1);
+	bench_run(&master, "update_canvas", "-", 0, bench_update_canvas, 10, 1);
+	bench_run(&master, "texture_parse", "-", 0, bench_texture_parse, 10, 1);
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		for (size_t j = 0; j < sizeof(densities) / sizeof(densities[0]); j++)
+		{
+			char map[32];
+			snprintf(map, sizeof(map), "%dx%d", sizes[i], sizes[i]);
+			if (bench_level(&master, sizes[i], densities[j], 0) != 0)
+			{
+				printf("malloc Error.\n");
+				return bench_quit(1);
+			}
+			bench_run(&master, "cast_ray", map, densities[j], bench_cast_rays, 64, RAYS_AMOUNT);
+			bench_run(&master, "cast_ray_fixed", map, densities[j], bench_cast_rays_fixed, 64, RAYS_AMOUNT);
+			bench_run(&master, "frame", map, densities[j], bench_frame, 64, 1);
+			bench_run(&master, "cast_ray_interlaced", map, densities[j], bench_cast_rays_interlaced, 64, RAYS_AMOUNT);
+			bench_run(&master, "frame_interlaced", map, densities[j], bench_frame_interlaced, 64, 1);
+			master.interlace.enabled = 0;
+			master.interlace.valid = 0;
+			master.player.direction = 0;
+			cast_rays(&master);
+			bench_run(&master, "draw_column", map, densities[j], bench_draw_columns, 20, RAYS_AMOUNT);
+			bench_run(&master, "update_screen", map, densities[j], bench_update_screen, 20, 1);
+			for (int x = 0; x < SCREEN_WIDTH; x++)
+			{
+				master.surface_top[x] = SCREEN_HEIGHT;
+				master.surface_bottom[x] = 0;
+			}
+			bench_run(&master, "draw_surfaces", map, densities[j], bench_draw_surfaces, 20, 1);
+			bench_run(&master, "handle_collisions", map, densities[j], bench_handle_collisions, 100000, 1);
+			bench_run(&master, "handle_collisions_fixed", map, densities[j], bench_handle_collisions_fixed, 100000, 1);
+			bench_level_free(&master);
+		}
+	}
+
+	for (size_t i = 0; i < sizeof(layout_sizes) / sizeof(layout_sizes[0]); i++)
+	{
+		for (size_t j = 0; j < sizeof(layout_densities) / sizeof(layout_densities[0]); j++)
+		{
+			for (int tiled = 0; tiled < 2; tiled++)
+			{
+				char map[32];
+				snprintf(map, sizeof(map), "%dx%d %s", layout_sizes[i], layout_sizes[i], tiled ? "tiled" : "linear");
+				if (bench_level(&master, layout_sizes[i], layout_densities[j], tiled) != 0)
+				{
+					printf("malloc Error.\n");
+					return bench_quit(1);
+				}
+				bench_run(&master, "cast_ray_roam", map, layout_densities[j], bench_cast_rays_roam, 256, RAYS_AMOUNT);
+				bench_run(&master, "cast_ray_fixed_roam", map, layout_densities[j], bench_cast_rays_fixed_roam, 256, RAYS_AMOUNT);
+				bench_level_free(&master);
+			}
+		}
+	}
+
+	return bench_quit(0);
+}
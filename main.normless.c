@@ -3,7 +3,14 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <math.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
 #include <SDL2/SDL.h>
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
 
 #include "ft_split.c"
 #include "ft_startswith.c"
@@ -17,7 +24,36 @@
 #define RAYS_AMOUNT 512
 #define RAYS_DISPLAY 10
 #define RAYS_FOV (PI / 3)
-#define RAYS_MAX_DISTANCE 100
+#define RAYS_MAX_DISTANCE 12
+#define RAYS_LAYERS 4
+#define LIGHT_LEVELS 32
+#define LIGHT_AMBIENT 0.45
+#define LIGHTS_MAX 16
+#define DOORS_MAX 256
+#define COLLISION_BOX 2
+#define LEVEL_TILED 0
+#define LEVEL_TILE_SHIFT 3
+#define LEVEL_TILE_MASK ((1 << LEVEL_TILE_SHIFT) - 1)
+#define LEVEL_CHUNK_SHIFT 6
+#define MINIMAP_TILE 24
+#define SURFACE_SPAN 16
+#define FOG_START 3
+#define FOG_END RAYS_MAX_DISTANCE
+#define FOG_COLOR 0
+#define TELEMETRY_NAME "/raycasting-telemetry"
+#define TELEMETRY_VERSION 1
+// Interlaced frames cast half the columns; last frame's pixels are only reused while standing or turning in place,
+// any movement draws every column again.
+#define INTERLACE 0
+#define INTERLACE_TOLERANCE 0.1
+#define FIXED_POINT 0
+#define FRAME_HASH 0
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_MAX (1 << 30)
+#define FIXED_ANGLES (RAYS_AMOUNT * 24)
+#define FIXED_FOV (FIXED_ANGLES / 6)
+#define FIXED_PI_Q30 3373259426LL
 
 typedef struct
 {
@@ -25,6 +61,14 @@ typedef struct
 	float y;
 } t_vec2;
 
+typedef Sint32 t_fixed;
+
+typedef struct
+{
+	t_fixed x;
+	t_fixed y;
+} t_fixed_vec2;
+
 typedef struct
 {
 	Uint8 r;
@@ -40,15 +84,60 @@ typedef struct s_texture
 	int is_solid;
 	Uint8 *array;
 	struct s_texture *next;
+	int is_transparent;
+	Uint8 opacity;
+	t_color key;
+	int is_thin;
 } t_texture;
 
 typedef struct
 {
 	int amount;
 	t_texture *list;
+	t_texture *lookup[256];
 	t_texture not_found;
 } t_textures;
 
+typedef struct
+{
+	SDL_Thread *thread;
+	SDL_atomic_t running;
+	SDL_atomic_t ready;
+	SDL_atomic_t loaded;
+	int synced;
+	int inotify;
+	void *pending[256];
+} t_stream;
+
+typedef struct
+{
+	Uint64 frame;
+	Uint64 frame_ns;
+	Uint64 present_ns;
+	Uint64 rays;
+	Uint64 cells;
+	Uint64 wall_pixels;
+	Uint64 surface_pixels;
+	Uint64 texels;
+	Uint64 collision_samples;
+	Uint64 texture_lookups;
+} t_counters;
+
+typedef struct
+{
+	Uint32 sequence;
+	Uint32 version;
+	t_counters last;
+	t_counters total;
+} t_telemetry_block;
+
+typedef struct
+{
+	t_counters frame;
+	t_counters total;
+	t_telemetry_block *shared;
+} t_telemetry;
+
 typedef struct
 {
 	int width;
@@ -57,13 +146,53 @@ typedef struct
 	Uint8 *array;
 } t_sdl_canvas;
 
+typedef struct
+{
+	int x;
+	int y;
+	t_fixed open;
+	t_fixed target;
+	t_fixed speed;
+} t_door;
+
 typedef struct
 {
 	int width;
 	int height;
+	int cells;
+	int stride;
+	int tiled;
 	char *array;
+	char *floor;
+	char *ceiling;
+	Uint8 *light;
+	Uint8 *wall;
+	Uint8 *solid;
+	Uint8 *transparent;
+	Uint8 *thin;
+	int thin_amount;
+	Uint16 *door;
+	Uint8 *names;
+	int chunk_stride;
+	int doors_amount;
+	t_door doors[DOORS_MAX];
+	Uint32 revision;
 } t_level;
 
+typedef struct
+{
+	t_vec2 position;
+	float radius;
+	float intensity;
+} t_light;
+
+typedef struct
+{
+	int amount;
+	t_light list[LIGHTS_MAX];
+	Uint8 table[LIGHT_LEVELS][256];
+} t_lighting;
+
 typedef struct
 {
 	t_vec2 position;
@@ -71,27 +200,81 @@ typedef struct
 	float distance;
 	int side;
 	char texture;
+	float offset;
+	t_fixed_vec2 fixed_position;
+	t_fixed fixed_distance;
+	t_fixed fixed_offset;
+	int fixed_angle;
+	int layers;
 } t_ray;
 
+typedef struct
+{
+	Sint64 top;
+	Sint64 height;
+	int texture_x;
+	int intensity;
+} t_column;
+
 typedef struct
 {
 	t_vec2 position;
 	float direction;
 	float speed;
 	float rotation_speed;
+	t_fixed_vec2 fixed_position;
+	int fixed_direction;
+	t_fixed fixed_speed;
+	int fixed_rotation_speed;
 	t_ray rays[RAYS_AMOUNT];
+	t_ray layers[RAYS_AMOUNT][RAYS_LAYERS];
 } t_player;
 
+typedef struct
+{
+	int enabled;
+	int parity;
+	int valid;
+	Uint32 revision;
+	t_ray rays[RAYS_AMOUNT];
+	float depth[RAYS_AMOUNT];
+	float angle[RAYS_AMOUNT];
+	int source[RAYS_AMOUNT];
+	int reuse[RAYS_AMOUNT];
+	t_vec2 position;
+	float direction;
+	t_column columns[RAYS_AMOUNT];
+	Uint8 *pixels;
+} t_interlace;
+
+typedef struct
+{
+	t_fixed sin[FIXED_ANGLES];
+	t_fixed tan[FIXED_ANGLES];
+	t_fixed rsin[FIXED_ANGLES];
+} t_fixed_tables;
+
 typedef struct
 {
 	SDL_Window *window;
 	t_sdl_canvas screen;
 	t_sdl_canvas minimap;
+	t_sdl_canvas tiles;
 	SDL_Renderer *renderer;
 	SDL_Texture *texture;
 	t_level level;
 	t_player player;
 	t_textures textures;
+	t_stream stream;
+	t_telemetry telemetry;
+	t_lighting lighting;
+	t_fixed_tables fixed;
+	int fixed_point;
+	t_interlace interlace;
+	Uint16 composite[SCREEN_HEIGHT][4];
+	t_column columns[RAYS_AMOUNT];
+	Sint16 surface_top[SCREEN_WIDTH];
+	Sint16 surface_bottom[SCREEN_WIDTH];
 	double clock;
 	double fps;
 } t_sdl_master;
@@ -100,14 +283,11 @@ void quit(int exit_code, t_sdl_master *master);
 
 t_texture texture_get(t_sdl_master *master, char name)
 {
-	t_texture *texture = master->textures.list;
-	while (texture != NULL)
+	t_texture *texture = master->textures.lookup[(Uint8) name];
+	master->telemetry.frame.texture_lookups++;
+	if (texture != NULL)
 	{
-		if (texture->name == name)
-		{
-			return *texture;
-		}
-		texture = texture->next;
+		return *texture;
 	}
 	return master->textures.not_found;
 }
@@ -120,6 +300,10 @@ t_texture *texture_add(t_sdl_master *master, char name, int size, int is_solid,
 	texture->is_solid = is_solid;
 	texture->array = array;
 	texture->next = NULL;
+	texture->is_transparent = 0;
+	texture->opacity = 255;
+	texture->key = (t_color){255, 0, 255, 0};
+	texture->is_thin = 0;
 	t_texture *last = master->textures.list;
 	if (last == NULL)
 	{
@@ -138,11 +322,15 @@ t_texture *texture_add(t_sdl_master *master, char name, int size, int is_solid,
 		}
 		last->next = texture;
 	}
+	if (master->textures.lookup[(Uint8) name] == NULL)
+	{
+		master->textures.lookup[(Uint8) name] = texture;
+	}
 	master->textures.amount++;
 	return texture;
 }
 
-void texture_parse(t_sdl_master *master, t_texture *texture, int fd)
+int texture_parse(t_texture *texture, int fd)
 {
 	char buffer;
 	char line[256];
@@ -160,6 +348,35 @@ void texture_parse(t_sdl_master *master, t_texture *texture, int fd)
 				line_len = 0;
 				continue;
 			}
+
+			if (ft_startswith(line, "# opacity "))
+			{
+				int opacity = atoi(ft_split(line, " ")[2]);
+				texture->opacity = opacity < 0 ? 0 : opacity > 255 ? 255 : opacity;
+				texture->is_transparent = texture->is_transparent || texture->opacity < 255;
+				line_len = 0;
+				continue;
+			}
+
+			if (ft_startswith(line, "# thin "))
+			{
+				int thin = atoi(ft_split(line, " ")[2]);
+				texture->is_thin = thin == 1 || thin == 2 ? thin : 0;
+				line_len = 0;
+				continue;
+			}
+
+			if (ft_startswith(line, "# alpha_key "))
+			{
+				char **split = ft_split(line, " ");
+				if (split[2] != NULL && split[3] != NULL && split[4] != NULL)
+				{
+					texture->key = (t_color){atoi(split[2]), atoi(split[3]), atoi(split[4]), 255};
+					texture->is_transparent = 1;
+				}
+				line_len = 0;
+				continue;
+			}
 			
 			if (line[0] == '\0' || line[0] == '#')
 			{
@@ -176,7 +393,13 @@ void texture_parse(t_sdl_master *master, t_texture *texture, int fd)
 			else if (current_line == 1)
 			{
 				texture->size = atoi(ft_split(line, " ")[0]);
-				texture->array = malloc(texture->size * texture->size * 3 * sizeof(Uint8));
+				texture->array = texture->size > 0 ? malloc(texture->size * texture->size * 3 * sizeof(Uint8)) : NULL;
+				if (texture->array == NULL)
+				{
+					printf("Size Error. (texture: '%s', size: '%d')\n", (char[]) {texture->name, '\0'}, texture->size);
+					close(fd);
+					return 1;
+				}
 				line_len = 0;
 				current_line++;
 				continue;
@@ -186,8 +409,14 @@ void texture_parse(t_sdl_master *master, t_texture *texture, int fd)
 			if (integer < 0 || integer > 255)
 			{
 				printf("Color Error. (texture: '%s', color: '%d')\n", (char[]) {texture->name, '\0'}, integer);
-				quit(1, master);
-				return;
+				close(fd);
+				return 1;
+			}
+			if (current_line - 3 >= texture->size * texture->size * 3)
+			{
+				printf("Data Error. (texture: '%s', too many colors)\n", (char[]) {texture->name, '\0'});
+				close(fd);
+				return 1;
 			}
 			texture->array[current_line - 3] = integer;
 
@@ -201,6 +430,206 @@ void texture_parse(t_sdl_master *master, t_texture *texture, int fd)
 		}
 	}
 	close(fd);
+	if (texture->array == NULL || current_line - 3 != texture->size * texture->size * 3)
+	{
+		printf("Data Error. (texture: '%s', incomplete file)\n", (char[]) {texture->name, '\0'});
+		return 1;
+	}
+	return 0;
+}
+
+int texture_stream_name(const char *file)
+{
+	if (file[0] == '\0' || strchr("123456789abcdef", file[0]) == NULL || strcmp(file + 1, ".ppm") != 0)
+		return 0;
+	return file[0];
+}
+
+void texture_stream_load(t_stream *stream, char name)
+{
+	char path[] = { "x.ppm" };
+	path[0] = name;
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return;
+	t_texture *texture = malloc(sizeof(t_texture));
+	if (texture == NULL)
+	{
+		close(fd);
+		return;
+	}
+	*texture = (t_texture){.name = name, .is_solid = 1, .opacity = 255, .key = {255, 0, 255, 0}};
+	if (texture_parse(texture, fd) != 0)
+	{
+		free(texture->array);
+		free(texture);
+		return;
+	}
+	t_texture *old = SDL_AtomicSetPtr(&stream->pending[(Uint8) name], texture);
+	if (old != NULL)
+	{
+		free(old->array);
+		free(old);
+	}
+	SDL_AtomicSet(&stream->ready, 1);
+}
+
+int texture_stream_thread(void *data)
+{
+	// Owns all texture I/O and parsing; finished textures are handed to the render thread through stream->pending.
+	t_stream *stream = data;
+	for (int i = 0; i < 15 && SDL_AtomicGet(&stream->running); i++)
+		texture_stream_load(stream, "123456789abcdef"[i]);
+	SDL_AtomicSet(&stream->loaded, 1);
+	if (stream->inotify == -1)
+		return 0;
+
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	while (SDL_AtomicGet(&stream->running))
+	{
+		struct pollfd poll_fd = {stream->inotify, POLLIN, 0};
+		if (poll(&poll_fd, 1, 100) <= 0)
+			continue;
+		ssize_t length = read(stream->inotify, buffer, sizeof(buffer));
+		char *cursor = buffer;
+		while (length > 0 && cursor < buffer + length)
+		{
+			struct inotify_event *event = (struct inotify_event *) cursor;
+			char name = event->len > 0 ? texture_stream_name(event->name) : 0;
+			if (name != 0)
+				texture_stream_load(stream, name);
+			cursor += sizeof(struct inotify_event) + event->len;
+		}
+	}
+	return 0;
+}
+
+int texture_stream_start(t_sdl_master *master)
+{
+	master->stream.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (master->stream.inotify == -1
+		|| inotify_add_watch(master->stream.inotify, ".", IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+	{
+		printf("inotify Error. (textures will not be hot reloaded)\n");
+	}
+	SDL_AtomicSet(&master->stream.running, 1);
+	SDL_AtomicSet(&master->stream.ready, 0);
+	SDL_AtomicSet(&master->stream.loaded, 0);
+	master->stream.thread = SDL_CreateThread(texture_stream_thread, "textures", &master->stream);
+	if (master->stream.thread == NULL)
+	{
+		printf("SDL_CreateThread Error: %s\n", SDL_GetError());
+		return 1;
+	}
+	return 0;
+}
+
+void texture_stream_stop(t_sdl_master *master)
+{
+	if (master->stream.thread != NULL)
+	{
+		SDL_AtomicSet(&master->stream.running, 0);
+		SDL_WaitThread(master->stream.thread, NULL);
+		master->stream.thread = NULL;
+	}
+	if (master->stream.inotify != -1)
+	{
+		close(master->stream.inotify);
+		master->stream.inotify = -1;
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		t_texture *texture = master->stream.pending[i];
+		if (texture != NULL)
+		{
+			free(texture->array);
+			free(texture);
+			master->stream.pending[i] = NULL;
+		}
+	}
+}
+
+void telemetry_start(t_sdl_master *master)
+{
+	// Missing shared memory only costs the external monitor, the game keeps running.
+	memset(&master->telemetry, 0, sizeof(master->telemetry));
+	int fd = shm_open(TELEMETRY_NAME, O_CREAT | O_RDWR, 0644);
+	if (fd == -1)
+	{
+		printf("shm_open Error.\n");
+		return;
+	}
+	if (ftruncate(fd, sizeof(t_telemetry_block)) == -1)
+	{
+		printf("ftruncate Error.\n");
+		close(fd);
+		return;
+	}
+	void *shared = mmap(NULL, sizeof(t_telemetry_block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shared == MAP_FAILED)
+	{
+		printf("mmap Error.\n");
+		return;
+	}
+	master->telemetry.shared = shared;
+	memset(master->telemetry.shared, 0, sizeof(t_telemetry_block));
+	master->telemetry.shared->version = TELEMETRY_VERSION;
+}
+
+void telemetry_copy(Uint64 *destination, const Uint64 *source, int amount)
+{
+	for (int i = 0; i < amount; i++)
+		__atomic_store_n(&destination[i], __atomic_load_n(&source[i], __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+void telemetry_publish(t_sdl_master *master)
+{
+	// Seqlock writer: an odd sequence tells readers the block is being rewritten and must be sampled again.
+	t_telemetry *telemetry = &master->telemetry;
+	Uint64 *frame = (Uint64 *) &telemetry->frame;
+	Uint64 *total = (Uint64 *) &telemetry->total;
+	for (size_t i = 0; i < sizeof(t_counters) / sizeof(Uint64); i++)
+		total[i] += frame[i];
+	telemetry->total.frame = telemetry->frame.frame;
+	if (telemetry->shared != NULL)
+	{
+		Uint32 sequence = telemetry->shared->sequence;
+		__atomic_store_n(&telemetry->shared->sequence, sequence + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		telemetry_copy((Uint64 *) &telemetry->shared->last, frame, sizeof(t_counters) / sizeof(Uint64));
+		telemetry_copy((Uint64 *) &telemetry->shared->total, total, sizeof(t_counters) / sizeof(Uint64));
+		__atomic_store_n(&telemetry->shared->sequence, sequence + 2, __ATOMIC_RELEASE);
+	}
+	Uint64 next = telemetry->frame.frame + 1;
+	memset(&telemetry->frame, 0, sizeof(t_counters));
+	telemetry->frame.frame = next;
+}
+
+int telemetry_read(t_telemetry_block *shared, t_counters *last, t_counters *total)
+{
+	// Seqlock reader: retries until it copied both blocks between two identical even sequences.
+	for (int attempt = 0; attempt < 1000; attempt++)
+	{
+		Uint32 sequence = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+		if (sequence & 1)
+			continue;
+		telemetry_copy((Uint64 *) last, (Uint64 *) &shared->last, sizeof(t_counters) / sizeof(Uint64));
+		telemetry_copy((Uint64 *) total, (Uint64 *) &shared->total, sizeof(t_counters) / sizeof(Uint64));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == sequence)
+			return 0;
+	}
+	return 1;
+}
+
+void telemetry_stop(t_sdl_master *master)
+{
+	if (master->telemetry.shared == NULL)
+		return;
+	munmap(master->telemetry.shared, sizeof(t_telemetry_block));
+	master->telemetry.shared = NULL;
+	shm_unlink(TELEMETRY_NAME);
 }
 
 void screen_draw_pixel(t_sdl_canvas *canvas, t_vec2 *point, t_color *color)
@@ -288,137 +717,706 @@ void screen_draw_circle(t_sdl_canvas *canvas, t_vec2 *point1, int radius, t_colo
 	}
 }
 
-int init(t_sdl_master *master)
+int level_index(const t_level *level, int x, int y)
 {
-	master->window = NULL;
-	master->renderer = NULL;
-	master->texture = NULL;
-	master->screen.width = SCREEN_WIDTH;
-	master->screen.height = SCREEN_HEIGHT;
-	master->screen.scale = 1;
-	master->screen.array = malloc(master->screen.width * master->screen.height * 4 * sizeof(Uint8));
-	master->level.width = 8;
-	master->level.height = 8;
-	master->level.array = malloc(master->level.width * master->level.height * sizeof(char));
-	master->minimap.width = master->level.width * 24;
-	master->minimap.height = master->level.height * 24;
-	master->minimap.scale = 1;
-	master->minimap.array = malloc(master->minimap.width * master->minimap.height * 4 * sizeof(Uint8));
-	master->player.position = (t_vec2){3.5, 5.5};
-	master->player.direction = -PI / 2;
-	master->player.speed = 0.06;
-	master->player.rotation_speed = 0.05;
-	master->textures.amount = 0;
-	master->textures.list = NULL;
-	master->textures.not_found.size = 4;
-	master->textures.not_found.is_solid = 1;
-	master->textures.not_found.array = malloc(master->textures.not_found.size * master->textures.not_found.size * 3 * sizeof(Uint8));
-	for (int i = 0; i < 4 * 4 * 3; i++)
-		master->textures.not_found.array[i] = (int[]){
-			255,   0, 255,      0,   0,   0,    255,   0, 255,      0,   0,   0,
-			  0,   0,   0,    255,   0, 255,      0,   0,   0,    255,   0, 255,
-			255,   0, 255,      0,   0,   0,    255,   0, 255,      0,   0,   0,
-			  0,   0,   0,    255,   0, 255,      0,   0,   0,     255,   0, 255
-		}[i];
-	master->clock = 0;
-	master->fps = 0;
+	// Tiled layout keeps each 8x8 block of cells contiguous, so a cell's vertical neighbours share its cache line.
+	if (!level->tiled)
+		return y * level->width + x;
+	return (((y >> LEVEL_TILE_SHIFT) * level->stride + (x >> LEVEL_TILE_SHIFT)) << (2 * LEVEL_TILE_SHIFT))
+		| ((y & LEVEL_TILE_MASK) << LEVEL_TILE_SHIFT) | (x & LEVEL_TILE_MASK);
+}
 
-	if (master->screen.array == NULL || master->minimap.array == NULL
-		|| master->level.array == NULL || master->textures.not_found.array == NULL)
+int lighting_add(t_sdl_master *master, t_vec2 position, float radius, float intensity)
+{
+	if (master->lighting.amount >= LIGHTS_MAX)
 	{
-		printf("malloc Error.\n");
 		return 1;
 	}
+	master->lighting.list[master->lighting.amount] = (t_light){position, radius, intensity};
+	master->lighting.amount++;
+	return 0;
+}
 
-	for (int i = 0; i < master->screen.width * master->screen.height * 4; i++)
-		master->screen.array[i] = (i % 4) == 3 ? 255 : 0;
-	for (int i = 0; i < master->minimap.width * master->minimap.height * 4; i++)
-		master->minimap.array[i] = (i % 4) == 3 ? 255 : 0;
-	for (int i = 0; i < master->level.width * master->level.height; i++)
-		master->level.array[i] = (char[]){
-			'1', '1', '1', '1', '1', '1', '1', '1',
-			'1', '0', '1', '0', '0', '0', '0', '1',
-			'1', '0', '1', '0', '0', '0', '0', '1',
-			'1', '0', '1', '0', '1', '1', '0', '1',
-			'1', '0', '0', '0', '0', '1', '0', '1',
-			'1', '0', '0', '0', '0', '0', '0', '1',
-			'1', '0', '0', '0', '0', '0', '0', '1',
-			'1', '1', '1', '1', '1', '1', '1', '1'
-		}[i];
-
-	texture_add(master, '0', 0, 0, NULL);
-
-	for (int i = 0; i < 16; i++)
+Uint64 fixed_sqrt(Uint64 value)
+{
+	Uint64 root = 0;
+	for (Uint64 bit = 1ULL << 62; bit != 0; bit >>= 2)
 	{
-		char path[] = { "x.ppm" };
-		path[0] = "123456789abcdef"[i];
-		int fd = open(path, O_RDONLY);
-		if (fd != -1)
-			texture_parse(master, texture_add(master, path[0], 0, 1, NULL), fd);
+		if (value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
 	}
-	
+	return root;
+}
 
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+void lighting_compute(t_sdl_master *master)
+{
+	// Every level fades toward FOG_COLOR, so walls, surfaces and the culled background meet in the same colour.
+	for (int level = 0; level < LIGHT_LEVELS; level++)
 	{
-		printf("SDL_Init Error: %s\n", SDL_GetError());
-		return 1;
+		for (int value = 0; value < 256; value++)
+		{
+			master->lighting.table[level][value] = FOG_COLOR + (value - FOG_COLOR) * level / (LIGHT_LEVELS - 1);
+		}
 	}
 
-	master->window = SDL_CreateWindow("Hello World!", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-										SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-	if (master->window == NULL)
+	for (int y = 0; y < master->level.height; y++)
 	{
-		printf("SDL_CreateWindow Error: %s\n", SDL_GetError());
-		return 1;
+		for (int x = 0; x < master->level.width; x++)
+		{
+			// Integer only, the fixed point path shades with these levels too.
+			Sint64 light = (Sint64) (LIGHT_AMBIENT * FIXED_ONE);
+			for (int i = 0; i < master->lighting.amount; i++)
+			{
+				t_light *source = &master->lighting.list[i];
+				Sint64 dx = (Sint64) x * FIXED_ONE + FIXED_ONE / 2 - (t_fixed) (source->position.x * FIXED_ONE);
+				Sint64 dy = (Sint64) y * FIXED_ONE + FIXED_ONE / 2 - (t_fixed) (source->position.y * FIXED_ONE);
+				Sint64 distance = (Sint64) fixed_sqrt((Uint64) (dx * dx + dy * dy));
+				Sint64 radius = (t_fixed) (source->radius * FIXED_ONE);
+				if (distance < radius)
+				{
+					light += (t_fixed) (source->intensity * FIXED_ONE) * (radius - distance) / radius;
+				}
+			}
+			if (light > FIXED_ONE)
+				light = FIXED_ONE;
+			master->level.light[level_index(&master->level, x, y)] = (Uint8) ((light * (LIGHT_LEVELS - 1) + FIXED_ONE / 2) / FIXED_ONE);
+		}
 	}
+}
 
-	master->renderer = SDL_CreateRenderer(master->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-	if (master->renderer == NULL)
+Uint8 lighting_get(t_sdl_master *master, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= master->level.width || y >= master->level.height)
 	{
-		printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
-		return 1;
+		return (Uint8) (LIGHT_AMBIENT * (LIGHT_LEVELS - 1) + 0.5);
 	}
+	return master->level.light[level_index(&master->level, x, y)];
+}
 
-	master->texture = SDL_CreateTexture(master->renderer,
-								SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
-								SCREEN_WIDTH, SCREEN_HEIGHT);
-	if (master->texture == NULL)
+t_fixed fixed_sin_compute(int angle)
+{
+	// Integer-only Taylor series on [0, PI / 4] (Q30), so the tables are identical on every build.
+	int cosine = angle > FIXED_ANGLES / 8;
+	if (cosine)
+		angle = FIXED_ANGLES / 4 - angle;
+	Sint64 x = angle * 2 * FIXED_PI_Q30 / FIXED_ANGLES;
+	Sint64 x2 = x * x / (1LL << 30);
+	Sint64 term = cosine ? 1LL << 30 : x;
+	Sint64 sum = term;
+	for (int n = 1; n <= 6; n++)
 	{
-		printf("SDL_CreateTexture Error: %s\n", SDL_GetError());
-		return 1;
+		term = -term * x2 / (1LL << 30);
+		term /= cosine ? (2 * n - 1) * (2 * n) : (2 * n) * (2 * n + 1);
+		sum += term;
 	}
+	return (t_fixed) ((sum + (1 << 13)) >> 14);
+}
 
-	return 0;
+t_fixed fixed_clamp(Sint64 value)
+{
+	if (value > FIXED_MAX)
+		return FIXED_MAX;
+	if (value < -FIXED_MAX)
+		return -FIXED_MAX;
+	return (t_fixed) value;
 }
 
-void quit(int exit_code, t_sdl_master *master)
+void fixed_compute(t_sdl_master *master)
 {
-	if (master->screen.array != NULL)
-	{
-		free(master->screen.array);
-	}
-	if (master->minimap.array != NULL)
-	{
-		free(master->minimap.array);
-	}
-	if (master->level.array != NULL)
+	int quarter = FIXED_ANGLES / 4;
+	for (int angle = 0; angle < FIXED_ANGLES; angle++)
 	{
-		free(master->level.array);
+		int rest = angle % quarter;
+		t_fixed sine = fixed_sin_compute((angle / quarter) % 2 == 0 ? rest : quarter - rest);
+		master->fixed.sin[angle] = angle / quarter < 2 ? sine : -sine;
 	}
-	if (master->window != NULL)
+	for (int angle = 0; angle < FIXED_ANGLES; angle++)
 	{
-		SDL_DestroyWindow(master->window);
-		if (master->renderer != NULL)
-		{
-			SDL_DestroyRenderer(master->renderer);
-			if (master->texture != NULL)
-			{
-				SDL_DestroyTexture(master->texture);
-			}
-		}
+		t_fixed sine = master->fixed.sin[angle];
+		t_fixed cosine = master->fixed.sin[(angle + quarter) % FIXED_ANGLES];
+		if (cosine == 0)
+			master->fixed.tan[angle] = sine > 0 ? FIXED_MAX : -FIXED_MAX;
+		else
+			master->fixed.tan[angle] = fixed_clamp((Sint64) sine * FIXED_ONE / cosine);
+		if (sine == 0)
+			master->fixed.rsin[angle] = FIXED_MAX;
+		else
+			master->fixed.rsin[angle] = fixed_clamp((1LL << (2 * FIXED_SHIFT)) / sine);
 	}
-	SDL_Quit();
-	printf("Exiting with code %d.\n", exit_code);
+}
+
+t_fixed fixed_cos(t_sdl_master *master, int angle)
+{
+	return master->fixed.sin[(angle + FIXED_ANGLES / 4) % FIXED_ANGLES];
+}
+
+t_fixed fixed_distance(t_sdl_master *master, int angle, Sint64 dx, Sint64 dy)
+{
+	// Divide by whichever of sin/cos is larger, through the reciprocal table.
+	t_fixed sine = master->fixed.sin[angle];
+	t_fixed cosine = fixed_cos(master, angle);
+	Sint64 distance;
+	if (abs(sine) >= abs(cosine))
+		distance = (dy < 0 ? -dy : dy) * llabs(master->fixed.rsin[angle]) >> FIXED_SHIFT;
+	else
+		distance = (dx < 0 ? -dx : dx) * llabs(master->fixed.rsin[(angle + FIXED_ANGLES / 4) % FIXED_ANGLES]) >> FIXED_SHIFT;
+	return distance > INT32_MAX ? INT32_MAX : (t_fixed) distance;
+}
+
+void fixed_sync(t_sdl_master *master)
+{
+	float direction = fmod(master->player.direction, 2 * PI);
+	if (direction < 0)
+		direction += 2 * PI;
+	master->player.fixed_position.x = (t_fixed) (master->player.position.x * FIXED_ONE);
+	master->player.fixed_position.y = (t_fixed) (master->player.position.y * FIXED_ONE);
+	master->player.fixed_direction = (int) (direction * FIXED_ANGLES / (2 * PI) + 0.5) % FIXED_ANGLES;
+}
+
+int level_init(t_sdl_master *master, int width, int height)
+{
+	// Storage is padded to whole tiles so either layout fits in the same amount of cells.
+	int cells = ((width + LEVEL_TILE_MASK) & ~LEVEL_TILE_MASK) * ((height + LEVEL_TILE_MASK) & ~LEVEL_TILE_MASK);
+	master->level.width = width;
+	master->level.height = height;
+	master->level.cells = cells;
+	master->level.stride = (width + LEVEL_TILE_MASK) >> LEVEL_TILE_SHIFT;
+	master->level.tiled = 0;
+	master->level.array = calloc(cells, sizeof(char));
+	master->level.floor = malloc(cells * sizeof(char));
+	master->level.ceiling = malloc(cells * sizeof(char));
+	master->level.light = calloc(cells, sizeof(Uint8));
+	master->level.wall = calloc((cells + 7) / 8, sizeof(Uint8));
+	master->level.solid = calloc((cells + 7) / 8, sizeof(Uint8));
+	master->level.transparent = calloc((cells + 7) / 8, sizeof(Uint8));
+	master->level.thin = calloc((cells + 7) / 8, sizeof(Uint8));
+	master->level.thin_amount = 0;
+	master->level.door = calloc(cells, sizeof(Uint16));
+	// One 256 bit set per chunk of cells, naming every texture ever placed in it.
+	master->level.chunk_stride = (width + (1 << LEVEL_CHUNK_SHIFT) - 1) >> LEVEL_CHUNK_SHIFT;
+	master->level.names = calloc(master->level.chunk_stride * ((height + (1 << LEVEL_CHUNK_SHIFT) - 1) >> LEVEL_CHUNK_SHIFT), 32);
+	master->level.doors_amount = 0;
+	master->level.revision = 0;
+	if (master->level.floor != NULL)
+		memset(master->level.floor, '0', cells);
+	if (master->level.ceiling != NULL)
+		memset(master->level.ceiling, '0', cells);
+	return master->level.array == NULL || master->level.floor == NULL || master->level.ceiling == NULL
+		|| master->level.light == NULL
+		|| master->level.wall == NULL || master->level.solid == NULL
+		|| master->level.transparent == NULL || master->level.thin == NULL || master->level.door == NULL
+		|| master->level.names == NULL;
+}
+
+int level_bit(Uint8 *bitmap, int index)
+{
+	return (bitmap[index >> 3] >> (index & 7)) & 1;
+}
+
+void level_bit_set(Uint8 *bitmap, int index, int value)
+{
+	if (value)
+		bitmap[index >> 3] |= 1 << (index & 7);
+	else
+		bitmap[index >> 3] &= ~(1 << (index & 7));
+}
+
+int level_layout_bytes(t_level *level, t_level *target, void **array, int size)
+{
+	Uint8 *source = *array;
+	Uint8 *result = calloc(level->cells, size);
+	if (result == NULL)
+		return 1;
+	for (int y = 0; y < level->height; y++)
+		for (int x = 0; x < level->width; x++)
+			memcpy(result + level_index(target, x, y) * size, source + level_index(level, x, y) * size, size);
+	free(source);
+	*array = result;
+	return 0;
+}
+
+int level_layout_bits(t_level *level, t_level *target, Uint8 **bitmap)
+{
+	Uint8 *result = calloc((level->cells + 7) / 8, sizeof(Uint8));
+	if (result == NULL)
+		return 1;
+	for (int y = 0; y < level->height; y++)
+		for (int x = 0; x < level->width; x++)
+			level_bit_set(result, level_index(target, x, y), level_bit(*bitmap, level_index(level, x, y)));
+	free(*bitmap);
+	*bitmap = result;
+	return 0;
+}
+
+int level_layout(t_sdl_master *master, int tiled)
+{
+	t_level *level = &master->level;
+	t_level target = *level;
+	target.tiled = tiled;
+	if (level->tiled == tiled)
+		return 0;
+	if (level_layout_bytes(level, &target, (void **) &level->array, sizeof(char))
+		|| level_layout_bytes(level, &target, (void **) &level->floor, sizeof(char))
+		|| level_layout_bytes(level, &target, (void **) &level->ceiling, sizeof(char))
+		|| level_layout_bytes(level, &target, (void **) &level->light, sizeof(Uint8))
+		|| level_layout_bytes(level, &target, (void **) &level->door, sizeof(Uint16))
+		|| level_layout_bits(level, &target, &level->wall)
+		|| level_layout_bits(level, &target, &level->solid)
+		|| level_layout_bits(level, &target, &level->transparent)
+		|| level_layout_bits(level, &target, &level->thin))
+	{
+		printf("level_layout Error.\n");
+		return 1;
+	}
+	level->tiled = tiled;
+	level->revision++;
+	return 0;
+}
+
+t_door *level_door_get(t_sdl_master *master, int index)
+{
+	if (master->level.door[index] == 0)
+		return NULL;
+	return &master->level.doors[master->level.door[index] - 1];
+}
+
+void level_draw_tile(t_sdl_master *master, int x, int y)
+{
+	int index = level_index(&master->level, x, y);
+	t_texture texture = texture_get(master, master->level.array[index]);
+	if (master->tiles.array == NULL)
+		return;
+	t_door *door = level_door_get(master, index);
+	int open = door == NULL ? 0 : (int) (((Sint64) door->open * MINIMAP_TILE) >> FIXED_SHIFT);
+	for (int i = 0; i < MINIMAP_TILE; i++)
+	{
+		Uint8 *pixel = master->tiles.array + ((y * MINIMAP_TILE + i) * master->tiles.width + x * MINIMAP_TILE) * 4;
+		for (int j = 0; j < MINIMAP_TILE * 4; j++)
+		{
+			pixel[j] = (j % 4) == 3 ? 255 : 0;
+		}
+	}
+	if (texture.size <= 0)
+		return;
+	for (int i = 0; i < MINIMAP_TILE; i++)
+	{
+		for (int j = open; j < MINIMAP_TILE; j++)
+		{
+			int texture_index = (i * texture.size / MINIMAP_TILE * texture.size + (j - open) * texture.size / MINIMAP_TILE) * 3;
+			screen_draw_pixel(&master->tiles,
+				&(t_vec2){x * MINIMAP_TILE + j, y * MINIMAP_TILE + i},
+				&(t_color){texture.array[texture_index],
+							texture.array[texture_index + 1],
+							texture.array[texture_index + 2], 196});
+		}
+	}
+}
+
+void level_refresh(t_sdl_master *master, int x, int y)
+{
+	int index = level_index(&master->level, x, y);
+	t_texture texture = texture_get(master, master->level.array[index]);
+	t_door *door = level_door_get(master, index);
+	int thin = texture.size > 0 && texture.is_thin;
+	master->level.thin_amount += thin - level_bit(master->level.thin, index);
+	level_bit_set(master->level.wall, index, texture.size > 0 && !thin);
+	level_bit_set(master->level.solid, index, texture.is_solid && (door == NULL || door->open < FIXED_ONE));
+	level_bit_set(master->level.transparent, index, texture.size > 0 && texture.is_transparent);
+	level_bit_set(master->level.thin, index, thin);
+	level_bit_set(master->level.names + ((y >> LEVEL_CHUNK_SHIFT) * master->level.chunk_stride + (x >> LEVEL_CHUNK_SHIFT)) * 32,
+		(Uint8) master->level.array[index], 1);
+	level_draw_tile(master, x, y);
+}
+
+void level_refresh_name(t_sdl_master *master, char name, int bits)
+{
+	// Only visits the chunks the texture was ever placed in; without bit changes only the minimap tiles are redrawn.
+	int chunk_height = (master->level.height + (1 << LEVEL_CHUNK_SHIFT) - 1) >> LEVEL_CHUNK_SHIFT;
+	for (int chunk = 0; chunk < master->level.chunk_stride * chunk_height; chunk++)
+	{
+		if (!level_bit(master->level.names + chunk * 32, (Uint8) name))
+			continue;
+		int start_x = (chunk % master->level.chunk_stride) << LEVEL_CHUNK_SHIFT;
+		int start_y = (chunk / master->level.chunk_stride) << LEVEL_CHUNK_SHIFT;
+		int end_x = start_x + (1 << LEVEL_CHUNK_SHIFT) < master->level.width ? start_x + (1 << LEVEL_CHUNK_SHIFT) : master->level.width;
+		int end_y = start_y + (1 << LEVEL_CHUNK_SHIFT) < master->level.height ? start_y + (1 << LEVEL_CHUNK_SHIFT) : master->level.height;
+		for (int y = start_y; y < end_y; y++)
+		{
+			for (int x = start_x; x < end_x; x++)
+			{
+				if (master->level.array[level_index(&master->level, x, y)] != name)
+					continue;
+				if (bits)
+					level_refresh(master, x, y);
+				else
+					level_draw_tile(master, x, y);
+			}
+		}
+	}
+}
+
+void level_set(t_sdl_master *master, int x, int y, char cell)
+{
+	if (x < 0 || y < 0 || x >= master->level.width || y >= master->level.height)
+		return;
+	int index = level_index(&master->level, x, y);
+	t_door *door = level_door_get(master, index);
+	if (door != NULL)
+	{
+		// Swap-remove keeps doors[] dense, so the freed slot is reused by the next level_door_add.
+		*door = master->level.doors[master->level.doors_amount - 1];
+		master->level.door[level_index(&master->level, door->x, door->y)] = door - master->level.doors + 1;
+		master->level.doors_amount--;
+		master->level.door[index] = 0;
+	}
+	master->level.array[index] = cell;
+	master->level.revision++;
+	level_refresh(master, x, y);
+}
+
+void level_set_surfaces(t_sdl_master *master, int x, int y, char floor, char ceiling)
+{
+	if (x < 0 || y < 0 || x >= master->level.width || y >= master->level.height)
+		return;
+	master->level.floor[level_index(&master->level, x, y)] = floor;
+	master->level.ceiling[level_index(&master->level, x, y)] = ceiling;
+	master->level.revision++;
+}
+
+t_door *level_door_add(t_sdl_master *master, int x, int y, char cell)
+{
+	if (x < 0 || y < 0 || x >= master->level.width || y >= master->level.height
+		|| master->level.doors_amount >= DOORS_MAX)
+		return NULL;
+	level_set(master, x, y, cell);
+	t_door *door = &master->level.doors[master->level.doors_amount];
+	*door = (t_door){x, y, 0, 0, FIXED_ONE / 30};
+	master->level.doors_amount++;
+	master->level.door[level_index(&master->level, x, y)] = master->level.doors_amount;
+	level_refresh(master, x, y);
+	return door;
+}
+
+void level_door_toggle(t_sdl_master *master, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= master->level.width || y >= master->level.height)
+		return;
+	t_door *door = level_door_get(master, level_index(&master->level, x, y));
+	if (door != NULL)
+		door->target = door->target == 0 ? FIXED_ONE : 0;
+}
+
+int level_door_occupied(t_sdl_master *master, t_door *door)
+{
+	// Same box the collision samples cover: COLLISION_BOX tenths of a cell around the player.
+	t_fixed_vec2 position = master->player.fixed_position;
+	t_fixed margin = COLLISION_BOX * FIXED_ONE / 10;
+	if (!master->fixed_point)
+		position = (t_fixed_vec2){(t_fixed) (master->player.position.x * FIXED_ONE), (t_fixed) (master->player.position.y * FIXED_ONE)};
+	return position.x + margin >= (t_fixed) door->x << FIXED_SHIFT && position.x - margin < (t_fixed) (door->x + 1) << FIXED_SHIFT
+		&& position.y + margin >= (t_fixed) door->y << FIXED_SHIFT && position.y - margin < (t_fixed) (door->y + 1) << FIXED_SHIFT;
+}
+
+void level_update(t_sdl_master *master)
+{
+	for (int i = 0; i < master->level.doors_amount; i++)
+	{
+		t_door *door = &master->level.doors[i];
+		if (door->open == door->target)
+			continue;
+		// A closing door waits while the player stands in its cell, it only turns solid once they have left.
+		if (door->target < door->open && level_door_occupied(master, door))
+			continue;
+		if (door->open < door->target)
+			door->open = door->open + door->speed > door->target ? door->target : door->open + door->speed;
+		else
+			door->open = door->open - door->speed < door->target ? door->target : door->open - door->speed;
+		master->level.revision++;
+		level_refresh(master, door->x, door->y);
+	}
+}
+
+void texture_install(t_sdl_master *master, t_texture *loaded)
+{
+	t_texture *texture = master->textures.lookup[(Uint8) loaded->name];
+	t_texture old = texture_get(master, loaded->name);
+	if (texture == NULL)
+		texture = texture_add(master, loaded->name, 0, 1, NULL);
+	free(texture->array);
+	texture->size = loaded->size;
+	texture->is_solid = loaded->is_solid;
+	texture->array = loaded->array;
+	texture->is_transparent = loaded->is_transparent;
+	texture->opacity = loaded->opacity;
+	texture->key = loaded->key;
+	texture->is_thin = loaded->is_thin;
+	free(loaded);
+	// Reused pixels would still show the old texels.
+	master->interlace.valid = 0;
+	int bits = (old.size > 0) != (texture->size > 0) || old.is_solid != texture->is_solid
+		|| old.is_transparent != texture->is_transparent || old.is_thin != texture->is_thin;
+	if (!bits && master->tiles.array == NULL)
+		return;
+	if (bits)
+		master->level.revision++;
+	level_refresh_name(master, texture->name, bits);
+}
+
+void texture_stream_swap(t_sdl_master *master)
+{
+	if (SDL_AtomicSet(&master->stream.ready, 0) == 0)
+		return;
+	for (int i = 0; i < 256; i++)
+	{
+		if (SDL_AtomicGetPtr(&master->stream.pending[i]) == NULL)
+			continue;
+		t_texture *loaded = SDL_AtomicSetPtr(&master->stream.pending[i], NULL);
+		if (loaded != NULL)
+			texture_install(master, loaded);
+	}
+}
+
+void texture_stream_update(t_sdl_master *master)
+{
+	// Called between frames: swaps in whatever the loader finished, never waits for it.
+	// Fixed point frames hold reloads back so a replay hashes the same while files change.
+	// They are skipped until the initial pass is complete, then it is swapped in once.
+	if (!master->fixed_point)
+		texture_stream_swap(master);
+	else if (!master->stream.synced && (master->stream.thread == NULL || SDL_AtomicGet(&master->stream.loaded)))
+	{
+		texture_stream_swap(master);
+		master->stream.synced = 1;
+	}
+}
+
+void texture_stream_sync(t_sdl_master *master)
+{
+	// Startup only, before the first frame: waits for the initial pass so fixed point frames do not depend on load timing.
+	while (master->stream.thread != NULL && !SDL_AtomicGet(&master->stream.loaded))
+		SDL_Delay(1);
+	texture_stream_swap(master);
+	master->stream.synced = 1;
+}
+
+int init(t_sdl_master *master)
+{
+	master->window = NULL;
+	master->renderer = NULL;
+	master->texture = NULL;
+	master->stream.thread = NULL;
+	master->stream.inotify = -1;
+	memset(master->stream.pending, 0, sizeof(master->stream.pending));
+	telemetry_start(master);
+	master->screen.width = SCREEN_WIDTH;
+	master->screen.height = SCREEN_HEIGHT;
+	master->screen.scale = 1;
+	master->screen.array = malloc(master->screen.width * master->screen.height * 4 * sizeof(Uint8));
+	int level_error = level_init(master, 8, 8);
+	master->minimap.width = master->level.width * MINIMAP_TILE;
+	master->minimap.height = master->level.height * MINIMAP_TILE;
+	master->minimap.scale = 1;
+	master->minimap.array = malloc(master->minimap.width * master->minimap.height * 4 * sizeof(Uint8));
+	master->tiles.width = master->minimap.width;
+	master->tiles.height = master->minimap.height;
+	master->tiles.scale = 1;
+	master->tiles.array = malloc(master->tiles.width * master->tiles.height * 4 * sizeof(Uint8));
+	master->player.position = (t_vec2){3.5, 5.5};
+	master->player.direction = -PI / 2;
+	master->player.speed = 0.06;
+	master->player.rotation_speed = 0.05;
+	master->player.fixed_position = (t_fixed_vec2){(t_fixed) (3.5 * FIXED_ONE), (t_fixed) (5.5 * FIXED_ONE)};
+	master->player.fixed_direction = FIXED_ANGLES * 3 / 4;
+	master->player.fixed_speed = (t_fixed) (0.06 * FIXED_ONE);
+	master->player.fixed_rotation_speed = (int) (0.05 * FIXED_ANGLES / (2 * PI) + 0.5);
+	master->fixed_point = FIXED_POINT;
+	master->interlace.enabled = INTERLACE;
+	master->interlace.valid = 0;
+	memset(master->interlace.reuse, -1, sizeof(master->interlace.reuse));
+	master->interlace.pixels = malloc(master->screen.width * master->screen.height * 4 * sizeof(Uint8));
+	master->textures.amount = 0;
+	master->textures.list = NULL;
+	memset(master->textures.lookup, 0, sizeof(master->textures.lookup));
+	master->lighting.amount = 0;
+	master->textures.not_found.size = 4;
+	master->textures.not_found.is_solid = 1;
+	master->textures.not_found.is_transparent = 0;
+	master->textures.not_found.opacity = 255;
+	master->textures.not_found.is_thin = 0;
+	master->textures.not_found.array = malloc(master->textures.not_found.size * master->textures.not_found.size * 3 * sizeof(Uint8));
+	for (int i = 0; i < 4 * 4 * 3; i++)
+		master->textures.not_found.array[i] = (int[]){
+			255,   0, 255,      0,   0,   0,    255,   0, 255,      0,   0,   0,
+			  0,   0,   0,    255,   0, 255,      0,   0,   0,    255,   0, 255,
+			255,   0, 255,      0,   0,   0,    255,   0, 255,      0,   0,   0,
+			  0,   0,   0,    255,   0, 255,      0,   0,   0,     255,   0, 255
+		}[i];
+	master->clock = 0;
+	master->fps = 0;
+
+	if (master->screen.array == NULL || master->minimap.array == NULL || master->tiles.array == NULL
+		|| master->interlace.pixels == NULL || level_error || master->textures.not_found.array == NULL)
+	{
+		printf("malloc Error.\n");
+		return 1;
+	}
+
+	for (int i = 0; i < master->screen.width * master->screen.height * 4; i++)
+		master->screen.array[i] = (i % 4) == 3 ? 255 : 0;
+	for (int i = 0; i < master->minimap.width * master->minimap.height * 4; i++)
+		master->minimap.array[i] = (i % 4) == 3 ? 255 : 0;
+	for (int i = 0; i < master->level.width * master->level.height; i++)
+		master->level.array[i] = (char[]){
+			'1', '1', '1', '1', '1', '1', '1', '1',
+			'1', '0', '1', '0', '0', '0', '0', '1',
+			'1', '0', '1', '0', '0', '0', '0', '1',
+			'1', '0', '1', '0', '1', '1', '0', '1',
+			'1', '0', '0', '0', '0', '1', '0', '1',
+			'1', '0', '0', '0', '0', '0', '0', '1',
+			'1', '0', '0', '0', '0', '0', '0', '1',
+			'1', '1', '1', '1', '1', '1', '1', '1'
+		}[i];
+	if (LEVEL_TILED && level_layout(master, 1) != 0)
+	{
+		return 1;
+	}
+
+	lighting_add(master, (t_vec2){6.5, 1.5}, 4, 0.6);
+	lighting_add(master, (t_vec2){1.5, 5.5}, 3, 0.4);
+	lighting_compute(master);
+	fixed_compute(master);
+
+	texture_add(master, '0', 0, 0, NULL);
+
+
+	for (int y = 0; y < master->level.height; y++)
+		for (int x = 0; x < master->level.width; x++)
+			level_refresh(master, x, y);
+	level_door_add(master, 2, 4, '1');
+	for (int y = 3; y < 7; y++)
+		for (int x = 3; x < 7; x++)
+			level_set_surfaces(master, x, y, '1', '0');
+
+	if (texture_stream_start(master) != 0)
+	{
+		return 1;
+	}
+	if (master->fixed_point)
+		texture_stream_sync(master);
+	
+
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+	{
+		printf("SDL_Init Error: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	master->window = SDL_CreateWindow("Hello World!", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+	if (master->window == NULL)
+	{
+		printf("SDL_CreateWindow Error: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	master->renderer = SDL_CreateRenderer(master->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	if (master->renderer == NULL)
+	{
+		printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	master->texture = SDL_CreateTexture(master->renderer,
+								SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+								SCREEN_WIDTH, SCREEN_HEIGHT);
+	if (master->texture == NULL)
+	{
+		printf("SDL_CreateTexture Error: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	return 0;
+}
+
+void quit(int exit_code, t_sdl_master *master)
+{
+	texture_stream_stop(master);
+	telemetry_stop(master);
+	if (master->screen.array != NULL)
+	{
+		free(master->screen.array);
+	}
+	if (master->interlace.pixels != NULL)
+	{
+		free(master->interlace.pixels);
+	}
+	if (master->minimap.array != NULL)
+	{
+		free(master->minimap.array);
+	}
+	if (master->level.array != NULL)
+	{
+		free(master->level.array);
+	}
+	if (master->level.floor != NULL)
+	{
+		free(master->level.floor);
+	}
+	if (master->level.ceiling != NULL)
+	{
+		free(master->level.ceiling);
+	}
+	if (master->level.light != NULL)
+	{
+		free(master->level.light);
+	}
+	if (master->level.wall != NULL)
+	{
+		free(master->level.wall);
+	}
+	if (master->level.solid != NULL)
+	{
+		free(master->level.solid);
+	}
+	if (master->level.transparent != NULL)
+	{
+		free(master->level.transparent);
+	}
+	if (master->level.thin != NULL)
+	{
+		free(master->level.thin);
+	}
+	if (master->level.names != NULL)
+	{
+		free(master->level.names);
+	}
+	if (master->level.door != NULL)
+	{
+		free(master->level.door);
+	}
+	if (master->tiles.array != NULL)
+	{
+		free(master->tiles.array);
+	}
+	if (master->window != NULL)
+	{
+		SDL_DestroyWindow(master->window);
+		if (master->renderer != NULL)
+		{
+			SDL_DestroyRenderer(master->renderer);
+			if (master->texture != NULL)
+			{
+				SDL_DestroyTexture(master->texture);
+			}
+		}
+	}
+	SDL_Quit();
+	printf("Exiting with code %d.\n", exit_code);
 	exit(0);
 }
 
@@ -432,152 +1430,983 @@ void update_canvas(int size, int width, Uint8 **pixels, t_sdl_canvas *canvas)
 			int window_index = (y * width + x) * 4;
 			if (window_index >= 0 && window_index + 3 < size)
 			{
-				(*pixels)[window_index] = ((*pixels)[window_index] * (255 - canvas->array[index + 3]) + canvas->array[index] * canvas->array[index + 3]) / 255;
-				(*pixels)[window_index + 1] = ((*pixels)[window_index + 1] * (255 - canvas->array[index + 3]) + canvas->array[index + 1] * canvas->array[index + 3]) / 255;
-				(*pixels)[window_index + 2] = ((*pixels)[window_index + 2] * (255 - canvas->array[index + 3]) + canvas->array[index + 2] * canvas->array[index + 3]) / 255;
-				(*pixels)[window_index + 3] = 255 - ((255 - (*pixels)[window_index + 3]) * (255 - canvas->array[index + 3]) / 255);
+				(*pixels)[window_index] = ((*pixels)[window_index] * (255 - canvas->array[index + 3]) + canvas->array[index] * canvas->array[index + 3]) / 255;
+				(*pixels)[window_index + 1] = ((*pixels)[window_index + 1] * (255 - canvas->array[index + 3]) + canvas->array[index + 1] * canvas->array[index + 3]) / 255;
+				(*pixels)[window_index + 2] = ((*pixels)[window_index + 2] * (255 - canvas->array[index + 3]) + canvas->array[index + 2] * canvas->array[index + 3]) / 255;
+				(*pixels)[window_index + 3] = 255 - ((255 - (*pixels)[window_index + 3]) * (255 - canvas->array[index + 3]) / 255);
+			}
+		}
+	}
+}
+
+void update_window(t_sdl_master *master)
+{
+	int size = SCREEN_WIDTH * SCREEN_HEIGHT * 4;
+	Uint8 *pixels = malloc(size * sizeof(Uint8));
+	if (pixels == NULL)
+	{
+		printf("malloc Error.\n");
+		quit(1, NULL);
+	}
+	for (int i = 0; i < size; i++)
+	{
+		pixels[i] = 0;
+	}
+	update_canvas(size, SCREEN_WIDTH, &pixels, &master->screen);
+	update_canvas(size, SCREEN_WIDTH, &pixels, &master->minimap);
+	SDL_UpdateTexture(master->texture, NULL, pixels, SCREEN_WIDTH * 4 * sizeof(Uint8));
+	SDL_RenderClear(master->renderer);
+	SDL_RenderCopy(master->renderer, master->texture, NULL, NULL);
+	SDL_RenderPresent(master->renderer);
+	free(pixels);
+}
+
+void update_minimap(t_sdl_master *master)
+{
+	memcpy(master->minimap.array, master->tiles.array, master->minimap.width * master->minimap.height * 4 * sizeof(Uint8));
+
+	for (int i = 0; i < RAYS_DISPLAY; i++)
+	{
+		t_ray ray = master->player.rays[i * RAYS_AMOUNT / RAYS_DISPLAY];
+		screen_draw_line(&master->minimap,
+			&(t_vec2){master->player.position.x * 24, master->player.position.y * 24},
+			&(t_vec2){ray.position.x * 24, ray.position.y * 24},
+			&(t_color){255, 255, 0, 255});
+	}
+
+	screen_draw_line(&master->minimap,
+		&(t_vec2){master->player.position.x * 24, master->player.position.y * 24},
+		&(t_vec2){master->player.position.x * 24 + 24 * cos(master->player.direction), master->player.position.y * 24 + 24 * sin(master->player.direction)},
+		&(t_color){255, 255, 255, 255});
+	screen_draw_circle(&master->minimap,
+		&(t_vec2){master->player.position.x * 24, master->player.position.y * 24},
+		6, &(t_color){0, 255, 255, 255}, 1);
+}
+
+int screen_column(t_sdl_master *master, t_ray *ray, int texture_size, t_column *column)
+{
+	if (ray->distance >= RAYS_MAX_DISTANCE)
+		return 0;
+	float distance = ray->distance * cos(ray->angle - master->player.direction);
+	if (distance < 0.01)
+		distance = 0.01;
+	float height = master->screen.height / distance;
+	column->height = (Sint64) (height * FIXED_ONE);
+	column->top = (Sint64) ((master->screen.height - height) / 2.0 * FIXED_ONE);
+	if (ray->side == 0)
+	{
+		column->texture_x = (int) ((ray->position.x - ray->offset) * texture_size) % texture_size;
+		if (ray->angle >= PI)
+			column->texture_x = texture_size - column->texture_x - 1;
+	}
+	else
+	{
+		column->texture_x = (int) ((ray->position.y - ray->offset) * texture_size) % texture_size;
+		if (ray->angle < PI / 2 || ray->angle >= 3 * PI / 2)
+			column->texture_x = texture_size - column->texture_x - 1;
+	}
+	int cell_x = (int) ray->position.x;
+	int cell_y = (int) ray->position.y;
+	// Thin walls are hit halfway across their own cell, which is the cell their light is read from.
+	if (ray->side == 0 && ray->position.y - cell_y != 0.5f)
+		cell_y += (ray->angle >= PI ? 0 : -1);
+	else if (ray->side == 1 && ray->position.x - cell_x != 0.5f)
+		cell_x += (ray->angle >= PI / 2 && ray->angle < 3 * PI / 2 ? 0 : -1);
+	float fog = (FOG_END - ray->distance) / (float) (FOG_END - FOG_START);
+	if (fog > 1)
+		fog = 1;
+	column->intensity = (int) (lighting_get(master, cell_x, cell_y) * (ray->side == 1 ? 1 : 0.8) * fog + 0.5);
+	return column->intensity > 0 && column->height > 0;
+}
+
+int screen_column_fixed(t_sdl_master *master, t_ray *ray, int texture_size, t_column *column)
+{
+	if (ray->fixed_distance >= RAYS_MAX_DISTANCE * FIXED_ONE)
+		return 0;
+	int delta = (ray->fixed_angle - master->player.fixed_direction + FIXED_ANGLES) % FIXED_ANGLES;
+	Sint64 distance = (Sint64) ray->fixed_distance * fixed_cos(master, delta) >> FIXED_SHIFT;
+	if (distance < FIXED_ONE / 100)
+		distance = FIXED_ONE / 100;
+	column->height = ((Sint64) master->screen.height << (2 * FIXED_SHIFT)) / distance;
+	column->top = (((Sint64) master->screen.height << FIXED_SHIFT) - column->height) / 2;
+	int right = ray->fixed_angle < FIXED_ANGLES / 4 || ray->fixed_angle >= 3 * FIXED_ANGLES / 4;
+	if (ray->side == 0)
+	{
+		column->texture_x = ((ray->fixed_position.x & (FIXED_ONE - 1)) - ray->fixed_offset) * texture_size >> FIXED_SHIFT;
+		if (ray->fixed_angle >= FIXED_ANGLES / 2)
+			column->texture_x = texture_size - column->texture_x - 1;
+	}
+	else
+	{
+		column->texture_x = ((ray->fixed_position.y & (FIXED_ONE - 1)) - ray->fixed_offset) * texture_size >> FIXED_SHIFT;
+		if (right)
+			column->texture_x = texture_size - column->texture_x - 1;
+	}
+	int cell_x = ray->fixed_position.x >> FIXED_SHIFT;
+	int cell_y = ray->fixed_position.y >> FIXED_SHIFT;
+	if (ray->side == 0 && (ray->fixed_position.y & (FIXED_ONE - 1)) != FIXED_ONE / 2)
+		cell_y += (ray->fixed_angle >= FIXED_ANGLES / 2 ? 0 : -1);
+	else if (ray->side == 1 && (ray->fixed_position.x & (FIXED_ONE - 1)) != FIXED_ONE / 2)
+		cell_x += (right ? -1 : 0);
+	Sint64 fog = ((Sint64) FOG_END * FIXED_ONE - ray->fixed_distance) / (FOG_END - FOG_START);
+	if (fog > FIXED_ONE)
+		fog = FIXED_ONE;
+	column->intensity = (int) ((lighting_get(master, cell_x, cell_y) * (ray->side == 1 ? 5 : 4) * fog / 5 + FIXED_ONE / 2) >> FIXED_SHIFT);
+	return column->intensity > 0 && column->height > 0;
+}
+
+void screen_column_span(t_sdl_master *master, t_column *column, int texture_size, int *y_start, int *y_end, Sint64 *texture_y, Sint64 *texture_y_inc)
+{
+	Sint64 bottom = column->top + column->height;
+	*y_start = column->top < 0 ? 0 : (int) ((column->top + FIXED_ONE - 1) >> FIXED_SHIFT);
+	*y_end = bottom > ((Sint64) master->screen.height << FIXED_SHIFT) ? master->screen.height : (int) (bottom >> FIXED_SHIFT);
+	*texture_y_inc = ((Sint64) texture_size << (2 * FIXED_SHIFT)) / column->height;
+	*texture_y = ((((Sint64) *y_start << FIXED_SHIFT) - column->top) * *texture_y_inc) >> FIXED_SHIFT;
+}
+
+void screen_draw_column(t_sdl_master *master, int i, t_texture *texture, t_column *column)
+{
+	Uint8 *shade = master->lighting.table[column->intensity];
+	int x_start = i * master->screen.width / RAYS_AMOUNT;
+	int x_end = (i + 1) * master->screen.width / RAYS_AMOUNT;
+	int y_start, y_end;
+	Sint64 texture_y, texture_y_inc;
+	screen_column_span(master, column, texture->size, &y_start, &y_end, &texture_y, &texture_y_inc);
+	if (y_end > y_start)
+	{
+		master->telemetry.frame.wall_pixels += (y_end - y_start) * (x_end - x_start);
+		master->telemetry.frame.texels += y_end - y_start;
+	}
+	for (int y = y_start; y < y_end; y++)
+	{
+		int pixel_index = ((int) (texture_y >> FIXED_SHIFT) * texture->size + column->texture_x) * 3;
+		Uint8 *pixel = master->screen.array + (y * master->screen.width + x_start) * 4;
+		for (int x = x_start; x < x_end; x++)
+		{
+			pixel[0] = shade[texture->array[pixel_index]];
+			pixel[1] = shade[texture->array[pixel_index + 1]];
+			pixel[2] = shade[texture->array[pixel_index + 2]];
+			pixel[3] = 255;
+			pixel += 4;
+		}
+		texture_y += texture_y_inc;
+	}
+}
+
+void screen_draw_layers(t_sdl_master *master, int i, t_ray *ray)
+{
+	// Front to back: composite keeps the premultiplied colour and the coverage of every row of the column.
+	// Walls share floor and ceiling height, so a farther hit always projects inside the span of a nearer one:
+	// once a hit's whole span lies in rows that are already opaque, it and everything behind it is hidden.
+	int opaque_start = 0;
+	int opaque_end = 0;
+	int touched_start = master->screen.height;
+	int touched_end = 0;
+	int texels = 0;
+	memset(master->composite, 0, sizeof(master->composite));
+	for (int layer = 0; layer <= ray->layers; layer++)
+	{
+		t_ray *hit = layer < ray->layers ? &master->player.layers[i][layer] : ray;
+		t_texture texture = texture_get(master, hit->texture);
+		t_column column;
+		if (texture.size <= 0 || !(master->fixed_point ? screen_column_fixed(master, hit, texture.size, &column)
+				: screen_column(master, hit, texture.size, &column)))
+			continue;
+		Uint8 *shade = master->lighting.table[column.intensity];
+		int y_start, y_end;
+		Sint64 texture_y, texture_y_inc;
+		screen_column_span(master, &column, texture.size, &y_start, &y_end, &texture_y, &texture_y_inc);
+		if (y_start >= opaque_start && y_end <= opaque_end)
+			break;
+		touched_start = y_start < touched_start ? y_start : touched_start;
+		touched_end = y_end > touched_end ? y_end : touched_end;
+		int open = 0;
+		for (int y = y_start; y < y_end; y++, texture_y += texture_y_inc)
+		{
+			Uint16 *composite = master->composite[y];
+			if (composite[3] >= 255)
+				continue;
+			Uint8 *texel = texture.array + ((int) (texture_y >> FIXED_SHIFT) * texture.size + column.texture_x) * 3;
+			texels++;
+			int alpha = texture.opacity;
+			if (texture.key.a && texel[0] == texture.key.r && texel[1] == texture.key.g && texel[2] == texture.key.b)
+				alpha = 0;
+			int weight = alpha * (255 - composite[3]) / 255;
+			composite[0] += shade[texel[0]] * weight / 255;
+			composite[1] += shade[texel[1]] * weight / 255;
+			composite[2] += shade[texel[2]] * weight / 255;
+			composite[3] += weight;
+			open += composite[3] < 255;
+		}
+		if (open == 0 && (opaque_end <= opaque_start || (y_start <= opaque_end && y_end >= opaque_start)))
+		{
+			opaque_start = opaque_end <= opaque_start || y_start < opaque_start ? y_start : opaque_start;
+			opaque_end = y_end > opaque_end ? y_end : opaque_end;
+		}
+	}
+
+	int x_start = i * master->screen.width / RAYS_AMOUNT;
+	int x_end = (i + 1) * master->screen.width / RAYS_AMOUNT;
+	master->telemetry.frame.texels += texels;
+	for (int y = touched_start; y < touched_end; y++)
+	{
+		Uint16 *composite = master->composite[y];
+		if (composite[3] == 0)
+			continue;
+		master->telemetry.frame.wall_pixels += x_end - x_start;
+		Uint8 *pixel = master->screen.array + (y * master->screen.width + x_start) * 4;
+		for (int x = x_start; x < x_end; x++)
+		{
+			pixel[0] = composite[0] + pixel[0] * (255 - composite[3]) / 255;
+			pixel[1] = composite[1] + pixel[1] * (255 - composite[3]) / 255;
+			pixel[2] = composite[2] + pixel[2] * (255 - composite[3]) / 255;
+			pixel[3] = 255;
+			pixel += 4;
+		}
+	}
+}
+
+void screen_surface_row(t_fixed position_x, t_fixed position_y, Sint64 distance, t_fixed *kx, t_fixed *ky, int spans, Sint32 *row_u, Sint32 *row_v)
+{
+	// Exact texture coordinates every SURFACE_SPAN pixels, linear steps in between.
+	for (int s = 0; s < spans; s++)
+	{
+		Sint32 u = position_x + (Sint32) (distance * kx[s] >> FIXED_SHIFT);
+		Sint32 v = position_y + (Sint32) (distance * ky[s] >> FIXED_SHIFT);
+		Sint32 du = (position_x + (Sint32) (distance * kx[s + 1] >> FIXED_SHIFT) - u) / SURFACE_SPAN;
+		Sint32 dv = (position_y + (Sint32) (distance * ky[s + 1] >> FIXED_SHIFT) - v) / SURFACE_SPAN;
+		Sint32 *span_u = row_u + s * SURFACE_SPAN;
+		Sint32 *span_v = row_v + s * SURFACE_SPAN;
+#ifdef __SSE2__
+		__m128i vector_u = _mm_setr_epi32(u, u + du, u + 2 * du, u + 3 * du);
+		__m128i vector_v = _mm_setr_epi32(v, v + dv, v + 2 * dv, v + 3 * dv);
+		__m128i step_u = _mm_set1_epi32(4 * du);
+		__m128i step_v = _mm_set1_epi32(4 * dv);
+		for (int j = 0; j < SURFACE_SPAN; j += 4)
+		{
+			_mm_storeu_si128((__m128i *) (span_u + j), vector_u);
+			_mm_storeu_si128((__m128i *) (span_v + j), vector_v);
+			vector_u = _mm_add_epi32(vector_u, step_u);
+			vector_v = _mm_add_epi32(vector_v, step_v);
+		}
+#else
+		for (int j = 0; j < SURFACE_SPAN; j++)
+		{
+			span_u[j] = u + j * du;
+			span_v[j] = v + j * dv;
+		}
+#endif
+	}
+}
+
+void screen_draw_surfaces(t_sdl_master *master)
+{
+	int width = master->screen.width;
+	int height = master->screen.height;
+	int spans = width / SURFACE_SPAN;
+	t_fixed kx[SCREEN_WIDTH / SURFACE_SPAN + 1];
+	t_fixed ky[SCREEN_WIDTH / SURFACE_SPAN + 1];
+	Sint32 row_u[SCREEN_WIDTH];
+	Sint32 row_v[SCREEN_WIDTH];
+	Uint8 row_levels[LIGHT_LEVELS];
+	t_fixed position_x, position_y;
+	Uint64 pixels = 0;
+	Uint64 texels = 0;
+	Uint64 lookups = 0;
+
+	// Floor offset of every span boundary, per unit of perpendicular distance.
+	if (master->fixed_point)
+	{
+		int direction = master->player.fixed_direction;
+		position_x = master->player.fixed_position.x;
+		position_y = master->player.fixed_position.y;
+		for (int s = 0; s <= spans; s++)
+		{
+			int angle = (direction - FIXED_FOV / 2 + s * SURFACE_SPAN * FIXED_FOV / width + FIXED_ANGLES) % FIXED_ANGLES;
+			t_fixed cosine = fixed_cos(master, (angle - direction + FIXED_ANGLES) % FIXED_ANGLES);
+			kx[s] = (Sint64) fixed_cos(master, angle) * FIXED_ONE / cosine;
+			ky[s] = (Sint64) master->fixed.sin[angle] * FIXED_ONE / cosine;
+		}
+	}
+	else
+	{
+		position_x = (t_fixed) (master->player.position.x * FIXED_ONE);
+		position_y = (t_fixed) (master->player.position.y * FIXED_ONE);
+		for (int s = 0; s <= spans; s++)
+		{
+			float angle = master->player.direction - RAYS_FOV / 2 + s * SURFACE_SPAN * RAYS_FOV / width;
+			float cosine = cos(angle - master->player.direction);
+			kx[s] = (t_fixed) (cos(angle) / cosine * FIXED_ONE);
+			ky[s] = (t_fixed) (sin(angle) / cosine * FIXED_ONE);
+		}
+	}
+
+	int ceiling_end = 0;
+	int floor_start = height;
+	for (int x = 0; x < width; x++)
+	{
+		if (master->surface_top[x] > ceiling_end)
+			ceiling_end = master->surface_top[x];
+		if (master->surface_bottom[x] < floor_start)
+			floor_start = master->surface_bottom[x];
+	}
+
+	for (int y = 0; y < height; y++)
+	{
+		int is_floor = y >= height / 2;
+		if (is_floor ? y < floor_start : y >= ceiling_end)
+			continue;
+		char *map = is_floor ? master->level.floor : master->level.ceiling;
+		Sint64 distance = ((Sint64) height << FIXED_SHIFT) / (is_floor ? 2 * y - height + 1 : height - 2 * y - 1);
+		Sint64 fog = ((Sint64) FOG_END * FIXED_ONE - distance) / (FOG_END - FOG_START);
+		if (fog > FIXED_ONE)
+			fog = FIXED_ONE;
+		if (fog < 0)
+			fog = 0;
+		Uint8 *pixel = master->screen.array + y * width * 4;
+		if (fog == 0)
+		{
+			// Past the fog end nothing is visible, the row shows the fog colour like the culled wall columns.
+			for (int x = 0; x < width; x++, pixel += 4)
+			{
+				if (is_floor ? y < master->surface_bottom[x] : y >= master->surface_top[x])
+					continue;
+				pixel[0] = FOG_COLOR;
+				pixel[1] = FOG_COLOR;
+				pixel[2] = FOG_COLOR;
+				pixel[3] = 255;
+			}
+			continue;
+		}
+		for (int level = 0; level < LIGHT_LEVELS; level++)
+			row_levels[level] = (level * fog + FIXED_ONE / 2) >> FIXED_SHIFT;
+		// The flat fallback has no cell lighting, but it fades into the fog like the textured surfaces.
+		Uint8 *flat_shade = master->lighting.table[row_levels[LIGHT_LEVELS - 1]];
+		t_color flat = is_floor ? (t_color){flat_shade[170], flat_shade[85], flat_shade[0], 255}
+			: (t_color){flat_shade[0], flat_shade[128], flat_shade[255], 255};
+		screen_surface_row(position_x, position_y, distance, kx, ky, spans, row_u, row_v);
+
+		for (int x = 0; x < width; x++, pixel += 4)
+		{
+			if (is_floor ? y < master->surface_bottom[x] : y >= master->surface_top[x])
+				continue;
+			pixels++;
+			int cell_x = row_u[x] >> FIXED_SHIFT;
+			int cell_y = row_v[x] >> FIXED_SHIFT;
+			t_texture *texture = NULL;
+			int index = 0;
+			if (cell_x >= 0 && cell_y >= 0 && cell_x < master->level.width && cell_y < master->level.height)
+			{
+				index = level_index(&master->level, cell_x, cell_y);
+				texture = master->textures.lookup[(Uint8) map[index]];
+				lookups++;
+				if (texture == NULL && map[index] != '0')
+					texture = &master->textures.not_found;
 			}
+			if (texture == NULL || texture->size <= 0 || texture->array == NULL)
+			{
+				pixel[0] = flat.r;
+				pixel[1] = flat.g;
+				pixel[2] = flat.b;
+				pixel[3] = 255;
+				continue;
+			}
+			Uint8 *shade = master->lighting.table[row_levels[master->level.light[index]]];
+			int texture_x = ((row_u[x] & (FIXED_ONE - 1)) * texture->size) >> FIXED_SHIFT;
+			int texture_y = ((row_v[x] & (FIXED_ONE - 1)) * texture->size) >> FIXED_SHIFT;
+			Uint8 *texel = texture->array + (texture_y * texture->size + texture_x) * 3;
+			texels++;
+			pixel[0] = shade[texel[0]];
+			pixel[1] = shade[texel[1]];
+			pixel[2] = shade[texel[2]];
+			pixel[3] = 255;
 		}
 	}
+	master->telemetry.frame.surface_pixels += pixels;
+	master->telemetry.frame.texels += texels;
+	master->telemetry.frame.texture_lookups += lookups;
 }
 
-void update_window(t_sdl_master *master)
+int screen_column_reusable(t_column *column, t_column *previous)
 {
-	int size = SCREEN_WIDTH * SCREEN_HEIGHT * 4;
-	Uint8 *pixels = malloc(size * sizeof(Uint8));
-	if (pixels == NULL)
+	// Last frame's pixels stand in when the wall lands within a pixel of where it was drawn, with the same texels and light.
+	return previous->intensity == column->intensity && previous->texture_x == column->texture_x
+		&& llabs(previous->top - column->top) < FIXED_ONE && llabs(previous->height - column->height) < FIXED_ONE;
+}
+
+void screen_copy_columns(t_sdl_master *master, int *reused)
+{
+	// Maps every reused screen column to its column in the previous frame, then copies row by row.
+	int width = master->screen.width;
+	int map[2 * SCREEN_WIDTH];
+	int amount = 0;
+	for (int i = 0; i < RAYS_AMOUNT; i++)
 	{
-		printf("malloc Error.\n");
-		quit(1, NULL);
+		if (!reused[i])
+			continue;
+		int j = master->interlace.reuse[i];
+		int source_start = j * width / RAYS_AMOUNT;
+		int source_end = (j + 1) * width / RAYS_AMOUNT;
+		for (int x = i * width / RAYS_AMOUNT; x < (i + 1) * width / RAYS_AMOUNT; x++)
+		{
+			int source = source_start + x - i * width / RAYS_AMOUNT;
+			map[amount++] = x;
+			map[amount++] = source < source_end ? source : source_end - 1;
+		}
 	}
-	for (int i = 0; i < size; i++)
+	if (amount == 0)
+		return;
+	for (int y = 0; y < master->screen.height; y++)
 	{
-		pixels[i] = 0;
+		Uint32 *pixel = (Uint32 *) master->screen.array + y * width;
+		Uint32 *source = (Uint32 *) master->interlace.pixels + y * width;
+		for (int k = 0; k < amount; k += 2)
+			pixel[map[k]] = source[map[k + 1]];
 	}
-	update_canvas(size, SCREEN_WIDTH, &pixels, &master->screen);
-	update_canvas(size, SCREEN_WIDTH, &pixels, &master->minimap);
-	SDL_UpdateTexture(master->texture, NULL, pixels, SCREEN_WIDTH * 4 * sizeof(Uint8));
-	SDL_RenderClear(master->renderer);
-	SDL_RenderCopy(master->renderer, master->texture, NULL, NULL);
-	SDL_RenderPresent(master->renderer);
-	free(pixels);
 }
 
-void update_minimap(t_sdl_master *master)
+void update_screen(t_sdl_master *master)
 {
-	for (int i = 0; i < master->minimap.width * master->minimap.height * 4; i++)
+	t_interlace *interlace = &master->interlace;
+	int reused[RAYS_AMOUNT];
+	// Interlaced frames alternate between two buffers, so last frame's pixels are still around to be reused.
+	if (interlace->enabled && interlace->pixels != NULL)
 	{
-		master->minimap.array[i] = (i % 4) == 3 ? 255 : 0;
+		Uint8 *previous = master->screen.array;
+		master->screen.array = interlace->pixels;
+		interlace->pixels = previous;
 	}
 
-	for (int y = 0; y < master->level.height; y++)
+	// Walls are laid out first so the surfaces skip every pixel an opaque wall will cover.
+	for (int x = 0; x < master->screen.width; x++)
 	{
-		for (int x = 0; x < master->level.width; x++)
+		master->surface_top[x] = master->screen.height;
+		master->surface_bottom[x] = 0;
+	}
+	for (int i = 0; i < RAYS_AMOUNT; i++)
+	{
+		t_ray *ray = &master->player.rays[i];
+		t_column *column = &master->columns[i];
+		t_texture texture = texture_get(master, ray->texture);
+		reused[i] = 0;
+		if (ray->layers > 0 || texture.size <= 0
+			|| !(master->fixed_point ? screen_column_fixed(master, ray, texture.size, column)
+				: screen_column(master, ray, texture.size, column)))
 		{
-			int index = y * master->level.width + x;
-			t_texture texture = texture_get(master, master->level.array[index]);
-			if (texture.size > 0)
-			{
-				/*screen_draw_rect(&master->minimap,
-					&(t_vec2){x * 24, y * 24}, &(t_vec2){x * 24 + 24, y * 24 + 24}, &(t_color){255, 0, 0, 196}, 1);*/
-				for (int i = 0; i < 24; i++)
-				{
-					for (int j = 0; j < 24; j++)
-					{
-						int texture_index = (i * texture.size / 24 * texture.size + j * texture.size / 24) * 3;
-						screen_draw_pixel(&master->minimap,
-							&(t_vec2){x * 24 + j, y * 24 + i},
-							&(t_color){texture.array[texture_index],
-										texture.array[texture_index + 1],
-										texture.array[texture_index + 2], 196});
-					}
-				}
-			}
+			column->intensity = 0;
+			continue;
+		}
+		int y_start, y_end;
+		Sint64 texture_y, texture_y_inc;
+		screen_column_span(master, column, texture.size, &y_start, &y_end, &texture_y, &texture_y_inc);
+		if (interlace->reuse[i] != -1 && interlace->pixels != NULL
+			&& screen_column_reusable(column, &interlace->columns[interlace->reuse[i]]))
+		{
+			// The surfaces skip the whole column, it is copied below.
+			reused[i] = 1;
+			y_start = 0;
+			y_end = master->screen.height;
+		}
+		for (int x = i * master->screen.width / RAYS_AMOUNT; x < (i + 1) * master->screen.width / RAYS_AMOUNT; x++)
+		{
+			master->surface_top[x] = y_start;
+			master->surface_bottom[x] = y_end;
 		}
 	}
 
-	for (int i = 0; i < RAYS_DISPLAY; i++)
+	screen_draw_surfaces(master);
+
+	for (int i = 0; i < RAYS_AMOUNT; i++)
 	{
-		t_ray ray = master->player.rays[i * RAYS_AMOUNT / RAYS_DISPLAY];
-		screen_draw_line(&master->minimap,
-			&(t_vec2){master->player.position.x * 24, master->player.position.y * 24},
-			&(t_vec2){ray.position.x * 24, ray.position.y * 24},
-			&(t_color){255, 255, 0, 255});
+		t_ray *ray = &master->player.rays[i];
+		if (reused[i])
+			continue;
+		if (ray->layers > 0)
+		{
+			screen_draw_layers(master, i, ray);
+			continue;
+		}
+		if (master->columns[i].intensity > 0)
+		{
+			t_texture texture = texture_get(master, ray->texture);
+			screen_draw_column(master, i, &texture, &master->columns[i]);
+		}
 	}
+	screen_copy_columns(master, reused);
+	memcpy(interlace->columns, master->columns, sizeof(interlace->columns));
+	memset(interlace->reuse, -1, sizeof(interlace->reuse));
+}
 
-	screen_draw_line(&master->minimap,
-		&(t_vec2){master->player.position.x * 24, master->player.position.y * 24},
-		&(t_vec2){master->player.position.x * 24 + 24 * cos(master->player.direction), master->player.position.y * 24 + 24 * sin(master->player.direction)},
-		&(t_color){255, 255, 255, 255});
-	screen_draw_circle(&master->minimap,
-		&(t_vec2){master->player.position.x * 24, master->player.position.y * 24},
-		6, &(t_color){0, 255, 255, 255}, 1);
+t_ray cast_layer_fixed(int angle, Sint64 x, Sint64 y, t_fixed distance, int side, char texture, t_fixed offset)
+{
+	return (t_ray){
+		.position = {x / (float) FIXED_ONE, y / (float) FIXED_ONE},
+		.angle = angle * 2 * PI / FIXED_ANGLES,
+		.distance = distance / (float) FIXED_ONE,
+		.side = side,
+		.texture = texture,
+		.offset = offset / (float) FIXED_ONE,
+		.fixed_position = {(t_fixed) x, (t_fixed) y},
+		.fixed_distance = distance,
+		.fixed_offset = offset,
+		.fixed_angle = angle};
 }
 
-void update_screen(t_sdl_master *master)
+void cast_layers(t_sdl_master *master, int i, int fixed, t_ray *vertical, int vertical_amount, t_ray *horizontal, int horizontal_amount)
 {
-	for (int i = 0; i < master->screen.width * master->screen.height * 4; i++)
+	// Merges the see-through hits of both sweeps, near to far, in front of the final hit.
+	t_ray *ray = &master->player.rays[i];
+	int v = 0;
+	int h = 0;
+	ray->layers = 0;
+	while (ray->layers < RAYS_LAYERS && (v < vertical_amount || h < horizontal_amount))
 	{
-		master->screen.array[i] = (i % 4) == 3 ? 255 : 0;
+		t_ray *next;
+		if (h >= horizontal_amount || (v < vertical_amount && (fixed
+				? vertical[v].fixed_distance < horizontal[h].fixed_distance
+				: vertical[v].distance < horizontal[h].distance)))
+			next = &vertical[v++];
+		else
+			next = &horizontal[h++];
+		if (fixed ? next->fixed_distance >= ray->fixed_distance : next->distance >= ray->distance)
+			break;
+		master->player.layers[i][ray->layers++] = *next;
 	}
+}
 
-	screen_draw_rect(&master->screen,
-		&(t_vec2){0, 0}, &(t_vec2){master->screen.width, master->screen.height / 2},
-		&(t_color){0, 128, 255, 255}, 1);
-	screen_draw_rect(&master->screen,
-		&(t_vec2){0, master->screen.height / 2}, &(t_vec2){master->screen.width, master->screen.height},
-		&(t_color){170, 85, 0, 255}, 1);
+int cast_thin(t_sdl_master *master, int x, int y, int orientation)
+{
+	// Thin walls only block the sweep that crosses their plane: 1 stands along x, 2 along y.
+	// They stand across the middle of their cell, so a sweep meets them half a step before each grid line.
+	if (x < 0 || y < 0 || x >= master->level.width || y >= master->level.height)
+		return -1;
+	int index = level_index(&master->level, x, y);
+	if (!level_bit(master->level.thin, index) || texture_get(master, master->level.array[index]).is_thin != orientation)
+		return -1;
+	return index;
+}
 
-	for (int i = 0; i < RAYS_AMOUNT; i++)
+int cast_hit(t_sdl_master *master, int index, t_vec2 position, float along, float angle, int side,
+	t_ray *layers, int *amount, char *texture, float *offset)
+{
+	// Returns 1 when the face stops the sweep, records see-through faces as layers and passes the open part of a door.
+	t_door *door = level_door_get(master, index);
+	if (door != NULL && along < door->open / (float) FIXED_ONE)
+		return 0;
+	*texture = master->level.array[index];
+	*offset = door == NULL ? 0 : door->open / (float) FIXED_ONE;
+	if (!level_bit(master->level.transparent, index) || *amount >= RAYS_LAYERS)
+		return 1;
+	layers[(*amount)++] = (t_ray){.position = position, .angle = angle,
+		.distance = sqrt(pow(position.x - master->player.position.x, 2) + pow(position.y - master->player.position.y, 2)),
+		.side = side, .texture = *texture, .offset = *offset};
+	*texture = '0';
+	return 0;
+}
+
+int cast_hit_fixed(t_sdl_master *master, int index, Sint64 x, Sint64 y, t_fixed along, int angle, int side,
+	t_ray *layers, int *amount, char *texture, t_fixed *offset)
+{
+	// Same as cast_hit on the fixed-point grid.
+	t_door *door = level_door_get(master, index);
+	if (door != NULL && along < door->open)
+		return 0;
+	*texture = master->level.array[index];
+	*offset = door == NULL ? 0 : door->open;
+	if (!level_bit(master->level.transparent, index) || *amount >= RAYS_LAYERS)
+		return 1;
+	layers[(*amount)++] = cast_layer_fixed(angle, x, y,
+		fixed_distance(master, angle, x - master->player.fixed_position.x, y - master->player.fixed_position.y), side, *texture, *offset);
+	*texture = '0';
+	return 0;
+}
+
+float cast_angle(float angle)
+{
+	while (angle < 0)
+		angle += 2 * PI;
+	while (angle >= 2 * PI)
+		angle -= 2 * PI;
+	return angle;
+}
+
+void cast_ray_retarget(t_sdl_master *master, t_ray *ray)
+{
+	// Keeps the world hit point, only the distance and angle are seen from the current camera.
+	float dx = ray->position.x - master->player.position.x;
+	float dy = ray->position.y - master->player.position.y;
+	ray->distance = sqrt(dx * dx + dy * dy);
+	ray->angle = cast_angle(atan2(dy, dx));
+}
+
+int cast_reconstruct_agrees(t_sdl_master *master, int i, t_ray *candidate, float distance)
+{
+	// The reprojected hit must lie on the same surface as one of the freshly cast neighbours.
+	for (int j = i - 1; j <= i + 1; j += 2)
+	{
+		if (j < 0 || j >= RAYS_AMOUNT)
+			continue;
+		t_ray *neighbour = &master->player.rays[j];
+		if (neighbour->texture == candidate->texture && neighbour->side == candidate->side
+			&& fabsf(distance - neighbour->distance) <= neighbour->distance * INTERLACE_TOLERANCE)
+			return 1;
+	}
+	return 0;
+}
+
+void cast_reconstruct(t_sdl_master *master, int parity)
+{
+	// Fills the columns of the given parity from last frame's hits, reprojected into the current camera.
+	t_interlace *interlace = &master->interlace;
+	float forward_x = cos(master->player.direction);
+	float forward_y = sin(master->player.direction);
+	float limit = tan(RAYS_FOV / 2 + RAYS_FOV / RAYS_AMOUNT);
+	// Pixels can only be reused while turning in place, moving shifts the floor and ceiling under every column.
+	int still = master->player.position.x == interlace->position.x && master->player.position.y == interlace->position.y;
+	int same = still && master->player.direction == interlace->direction;
+	for (int i = parity; i < RAYS_AMOUNT; i += 2)
+	{
+		t_ray *old = &interlace->rays[i];
+		int valid = same && old->texture != '0' && old->layers == 0;
+		interlace->depth[i] = valid ? old->distance : RAYS_MAX_DISTANCE;
+		interlace->angle[i] = -RAYS_FOV / 2 + i * RAYS_FOV / RAYS_AMOUNT;
+		interlace->source[i] = valid ? i : -1;
+	}
+	for (int j = 0; j < RAYS_AMOUNT && !same; j++)
 	{
-		t_ray ray = master->player.rays[i];
-		float distance = ray.distance * cos(ray.angle - master->player.direction);
-		float height = master->screen.height / distance;
-		float position = (master->screen.height - height) / 2.0;
-		float tiling = master->screen.width / (float) RAYS_AMOUNT;
-		t_texture texture = texture_get(master, ray.texture);
-		int texture_size = texture.size;
-		float texture_x;
-		if (ray.side == 0)
+		t_ray *old = &interlace->rays[j];
+		if (old->texture == '0' || old->layers > 0)
+			continue;
+		float dx = old->position.x - master->player.position.x;
+		float dy = old->position.y - master->player.position.y;
+		float depth = dx * forward_x + dy * forward_y;
+		float across = dy * forward_x - dx * forward_y;
+		if (depth <= 0 || fabsf(across) > depth * limit)
+			continue;
+		// Inside the field of view |t| < 0.6, where the arctangent series is well below a column of error.
+		float t = across / depth;
+		float t2 = t * t;
+		float angle = t * (1 - t2 * (1 / 3.0f - t2 * (1 / 5.0f - t2 * (1 / 7.0f - t2 / 9.0f))));
+		// Turning in place snaps to the nearest column of the missing parity, so nearly every one gets a hit whose pixels
+		// can be reused; otherwise only exact matches are kept, which is more accurate.
+		float column = (angle + RAYS_FOV / 2) * (RAYS_AMOUNT / RAYS_FOV);
+		int i = still ? 2 * (int) floorf((column - parity) / 2 + 0.5f) + parity : (int) (column + 0.5f);
+		if (i < 0 || i >= RAYS_AMOUNT || (i & 1) != parity)
+			continue;
+		// The hit closest to the column's own angle wins, depth only breaks ties.
+		float error = fabsf(column - i);
+		float taken = (interlace->angle[i] + RAYS_FOV / 2) * (RAYS_AMOUNT / RAYS_FOV);
+		float best = fabsf(taken - i);
+		float distance = sqrtf(dx * dx + dy * dy);
+		if (interlace->source[i] != -1 && (error > best || (error == best && distance >= interlace->depth[i])))
+			continue;
+		interlace->depth[i] = distance;
+		interlace->angle[i] = angle;
+		interlace->source[i] = j;
+	}
+
+	for (int i = parity; i < RAYS_AMOUNT; i += 2)
+	{
+		t_ray *ray = &master->player.rays[i];
+		if (interlace->source[i] != -1
+			&& (same || cast_reconstruct_agrees(master, i, &interlace->rays[interlace->source[i]], interlace->depth[i])))
 		{
-			texture_x = (int) (ray.position.x * texture_size) % texture_size;
-			if (ray.angle >= PI)
-				texture_x = texture_size - texture_x - 1;
+			*ray = interlace->rays[interlace->source[i]];
+			ray->distance = interlace->depth[i];
+			ray->angle = cast_angle(master->player.direction + interlace->angle[i]);
+			// Pixels are only taken from a hit that reprojects within half a column, i.e. onto this very column.
+			float column = (interlace->angle[i] + RAYS_FOV / 2) * (RAYS_AMOUNT / RAYS_FOV);
+			interlace->reuse[i] = still && fabsf(column - i) < 0.5f ? interlace->source[i] : -1;
+			continue;
 		}
-		else
+		// Disocclusion or a depth edge: rebuild the column from the freshly cast neighbours instead.
+		t_ray *left = i > 0 ? &master->player.rays[i - 1] : NULL;
+		t_ray *right = i + 1 < RAYS_AMOUNT ? &master->player.rays[i + 1] : NULL;
+		if (left != NULL && right != NULL && left->texture == right->texture && left->side == right->side
+			&& left->layers == 0 && right->layers == 0 && left->offset == right->offset
+			&& (left->side == 0 ? left->position.y == right->position.y : left->position.x == right->position.x))
+		{
+			*ray = *left;
+			ray->position = (t_vec2){(left->position.x + right->position.x) / 2, (left->position.y + right->position.y) / 2};
+			cast_ray_retarget(master, ray);
+			continue;
+		}
+		t_ray *nearest = right == NULL || (left != NULL && left->distance <= right->distance) ? left : right;
+		*ray = *nearest;
+		memcpy(master->player.layers[i], master->player.layers[nearest - master->player.rays], sizeof(master->player.layers[i]));
+	}
+}
+
+void cast_rays(t_sdl_master *master)
+{
+	// Interlaced frames cast one parity of columns and reconstruct the other from the previous frame.
+	t_interlace *interlace = &master->interlace;
+	int first = 0;
+	int step = 1;
+	if (interlace->enabled && interlace->valid && interlace->revision == master->level.revision)
+	{
+		memcpy(interlace->rays, master->player.rays, sizeof(interlace->rays));
+		first = interlace->parity;
+		step = 2;
+	}
+	memset(interlace->reuse, -1, sizeof(interlace->reuse));
+	Uint64 cells = 0;
+	Uint64 rays = 0;
+	for (int i = first; i < RAYS_AMOUNT; i += step)
+	{
+		rays++;
+		float angle = cast_angle(master->player.direction - RAYS_FOV / 2 + i * RAYS_FOV / RAYS_AMOUNT);
+
+		float dx, dy;
+
+		t_vec2 vertical_position;
+		char vertical_texture = '0';
+		float vertical_offset = 0;
+		t_ray vertical_layers[RAYS_LAYERS];
+		int vertical_amount = 0;
+		float atan = -1 / tan(angle);
+		vertical_position.y = (int) master->player.position.y + (angle >= PI ? 0 : 1);
+		vertical_position.x = master->player.position.x + (master->player.position.y - vertical_position.y) * atan;
+		dy = (angle >= PI ? -1 : 1);
+		dx = -dy * atan;
+		while (vertical_position.y >= 0 && vertical_position.y < master->level.height)
+		{
+			cells++;
+			if (master->level.thin_amount > 0 && (vertical_position.y - dy / 2 - master->player.position.y) * dy > 0)
+			{
+				t_vec2 middle = {vertical_position.x - dx / 2, vertical_position.y - dy / 2};
+				int thin = cast_thin(master, (int) floorf(middle.x), (int) floorf(middle.y), 1);
+				if (thin != -1 && cast_hit(master, thin, middle, middle.x - floorf(middle.x), angle, 0,
+					vertical_layers, &vertical_amount, &vertical_texture, &vertical_offset))
+				{
+					vertical_position = middle;
+					break;
+				}
+			}
+			int cell_x = (int) vertical_position.x;
+			int cell_y = (int) (vertical_position.y + (angle >= PI ? -1 : 0));
+			if (cell_x < 0 || cell_y < 0 || cell_x >= master->level.width || cell_y >= master->level.height)
+				break;
+			int index = level_index(&master->level, cell_x, cell_y);
+			if (pow(vertical_position.x - master->player.position.x, 2) + pow(vertical_position.y - master->player.position.y, 2)
+				> RAYS_MAX_DISTANCE * RAYS_MAX_DISTANCE)
+			{
+				vertical_texture = '0';
+				break;
+			}
+			if (level_bit(master->level.wall, index) && cast_hit(master, index, vertical_position, vertical_position.x - (int) vertical_position.x, angle, 0,
+				vertical_layers, &vertical_amount, &vertical_texture, &vertical_offset))
+				break;
+			vertical_position.y += dy;
+			vertical_position.x += dx;
+		}
+		float vertical_distance = sqrt(pow(vertical_position.x - master->player.position.x, 2) + pow(vertical_position.y - master->player.position.y, 2));
+
+		t_vec2 horizontal_position;
+		char horizontal_texture = '0';
+		float horizontal_offset = 0;
+		t_ray horizontal_layers[RAYS_LAYERS];
+		int horizontal_amount = 0;
+		float ntan = -tan(angle);
+		horizontal_position.x = (int) master->player.position.x + (angle >= PI / 2 && angle < 3 * PI / 2 ? 0 : 1);
+		horizontal_position.y = master->player.position.y + (master->player.position.x - horizontal_position.x) * ntan;
+		dx = (angle >= PI / 2 && angle < 3 * PI / 2 ? -1 : 1);
+		dy = -dx * ntan;
+		while (horizontal_position.x >= 0 && horizontal_position.x < master->level.width)
+		{
+			cells++;
+			if (master->level.thin_amount > 0 && (horizontal_position.x - dx / 2 - master->player.position.x) * dx > 0)
+			{
+				t_vec2 middle = {horizontal_position.x - dx / 2, horizontal_position.y - dy / 2};
+				int thin = cast_thin(master, (int) floorf(middle.x), (int) floorf(middle.y), 2);
+				if (thin != -1 && cast_hit(master, thin, middle, middle.y - floorf(middle.y), angle, 1,
+					horizontal_layers, &horizontal_amount, &horizontal_texture, &horizontal_offset))
+				{
+					horizontal_position = middle;
+					break;
+				}
+			}
+			int cell_x = (int) (horizontal_position.x + (angle >= PI / 2 && angle < 3 * PI / 2 ? -1 : 0));
+			int cell_y = (int) horizontal_position.y;
+			if (cell_x < 0 || cell_y < 0 || cell_x >= master->level.width || cell_y >= master->level.height)
+				break;
+			int index = level_index(&master->level, cell_x, cell_y);
+			if (pow(horizontal_position.x - master->player.position.x, 2) + pow(horizontal_position.y - master->player.position.y, 2)
+				> RAYS_MAX_DISTANCE * RAYS_MAX_DISTANCE)
+			{
+				horizontal_texture = '0';
+				break;
+			}
+			if (level_bit(master->level.wall, index) && cast_hit(master, index, horizontal_position, horizontal_position.y - (int) horizontal_position.y, angle, 1,
+				horizontal_layers, &horizontal_amount, &horizontal_texture, &horizontal_offset))
+				break;
+			horizontal_position.x += dx;
+			horizontal_position.y += dy;
+		}
+		float horizontal_distance = sqrt(pow(horizontal_position.x - master->player.position.x, 2) + pow(horizontal_position.y - master->player.position.y, 2));
+
+		master->player.rays[i].position = vertical_distance < horizontal_distance ? vertical_position : horizontal_position;
+		master->player.rays[i].angle = angle;
+		master->player.rays[i].distance = vertical_distance < horizontal_distance ? vertical_distance : horizontal_distance;
+		master->player.rays[i].side = vertical_distance < horizontal_distance ? 0 : 1;
+		master->player.rays[i].texture = vertical_distance < horizontal_distance ? vertical_texture : horizontal_texture;
+		master->player.rays[i].offset = vertical_distance < horizontal_distance ? vertical_offset : horizontal_offset;
+		cast_layers(master, i, 0, vertical_layers, vertical_amount, horizontal_layers, horizontal_amount);
+
+		if (master->player.rays[i].distance < 0.1)
+		{
+			break;
+		}
+	}
+	master->telemetry.frame.rays += rays;
+	master->telemetry.frame.cells += cells;
+
+	if (step == 2)
+		cast_reconstruct(master, first ^ 1);
+	interlace->parity ^= 1;
+	interlace->valid = interlace->enabled;
+	interlace->revision = master->level.revision;
+	interlace->position = master->player.position;
+	interlace->direction = master->player.direction;
+}
+
+void cast_rays_fixed(t_sdl_master *master)
+{
+	Sint64 player_x = master->player.fixed_position.x;
+	Sint64 player_y = master->player.fixed_position.y;
+	Sint64 width = (Sint64) master->level.width << FIXED_SHIFT;
+	Sint64 height = (Sint64) master->level.height << FIXED_SHIFT;
+	Uint64 cells = 0;
+	// Reconstruction is float only, the deterministic path always casts every column.
+	master->interlace.valid = 0;
+	memset(master->interlace.reuse, -1, sizeof(master->interlace.reuse));
+	for (int i = 0; i < RAYS_AMOUNT; i++)
+	{
+		int angle = (master->player.fixed_direction - FIXED_FOV / 2 + i * FIXED_FOV / RAYS_AMOUNT + FIXED_ANGLES) % FIXED_ANGLES;
+		int down = angle < FIXED_ANGLES / 2;
+		int right = angle < FIXED_ANGLES / 4 || angle >= 3 * FIXED_ANGLES / 4;
+		Sint64 dx, dy;
+
+		Sint64 vertical_x, vertical_y;
+		char vertical_texture = '0';
+		t_fixed vertical_offset = 0;
+		t_ray vertical_layers[RAYS_LAYERS];
+		int vertical_amount = 0;
+		t_fixed cotangent = master->fixed.tan[(FIXED_ANGLES / 4 - angle + FIXED_ANGLES) % FIXED_ANGLES];
+		vertical_y = (player_y & ~(Sint64) (FIXED_ONE - 1)) + (down ? FIXED_ONE : 0);
+		vertical_x = player_x + ((vertical_y - player_y) * cotangent >> FIXED_SHIFT);
+		dy = down ? FIXED_ONE : -FIXED_ONE;
+		dx = down ? cotangent : -cotangent;
+		Sint64 vertical_limit = (Sint64) RAYS_MAX_DISTANCE * abs(master->fixed.sin[angle]);
+		while (vertical_y >= 0 && vertical_y < height && vertical_x >= 0 && vertical_x < width)
 		{
-			texture_x = (int) (ray.position.y * texture_size) % texture_size;
-			if (ray.angle < PI / 2 || ray.angle >= 3 * PI / 2)
-				texture_x = texture_size - texture_x - 1;
+			cells++;
+			if (master->level.thin_amount > 0)
+			{
+				Sint64 middle_x = vertical_x - dx / 2;
+				Sint64 middle_y = vertical_y - dy / 2;
+				int thin = (down ? middle_y > player_y : middle_y < player_y)
+					? cast_thin(master, (int) (middle_x >> FIXED_SHIFT), (int) (middle_y >> FIXED_SHIFT), 1) : -1;
+				if (thin != -1 && cast_hit_fixed(master, thin, middle_x, middle_y, middle_x & (FIXED_ONE - 1), angle, 0,
+					vertical_layers, &vertical_amount, &vertical_texture, &vertical_offset))
+				{
+					vertical_x = middle_x;
+					vertical_y = middle_y;
+					break;
+				}
+			}
+			if (llabs(vertical_y - player_y) > vertical_limit)
+			{
+				vertical_texture = '0';
+				break;
+			}
+			int cell_y = (int) (vertical_y >> FIXED_SHIFT) + (down ? 0 : -1);
+			if (cell_y < 0)
+				break;
+			int index = level_index(&master->level, (int) (vertical_x >> FIXED_SHIFT), cell_y);
+			if (level_bit(master->level.wall, index) && cast_hit_fixed(master, index, vertical_x, vertical_y, vertical_x & (FIXED_ONE - 1), angle, 0,
+				vertical_layers, &vertical_amount, &vertical_texture, &vertical_offset))
+				break;
+			vertical_y += dy;
+			vertical_x += dx;
 		}
-		float texture_y = 0;
-		float texture_y_inc = texture_size / height;
-		float shade = ray.side == 1 ? 1 : 0.8;
-		for (size_t y = 0; y < height; y++)
+		t_fixed vertical_distance = fixed_distance(master, angle, vertical_x - player_x, vertical_y - player_y);
+
+		Sint64 horizontal_x, horizontal_y;
+		char horizontal_texture = '0';
+		t_fixed horizontal_offset = 0;
+		t_ray horizontal_layers[RAYS_LAYERS];
+		int horizontal_amount = 0;
+		t_fixed tangent = master->fixed.tan[angle];
+		horizontal_x = (player_x & ~(Sint64) (FIXED_ONE - 1)) + (right ? FIXED_ONE : 0);
+		horizontal_y = player_y + ((horizontal_x - player_x) * tangent >> FIXED_SHIFT);
+		dx = right ? FIXED_ONE : -FIXED_ONE;
+		dy = right ? tangent : -tangent;
+		Sint64 horizontal_limit = (Sint64) RAYS_MAX_DISTANCE * abs(fixed_cos(master, angle));
+		while (horizontal_x >= 0 && horizontal_x < width && horizontal_y >= 0 && horizontal_y < height)
 		{
-			int pixel_index = ((int) texture_y * texture_size + (int) texture_x) * 3;
-			t_color color = {texture.array[pixel_index] * shade,
-								texture.array[pixel_index + 1] * shade,
-								texture.array[pixel_index + 2] * shade,
-								255};
-			screen_draw_rect(&master->screen,
-				&(t_vec2){i * tiling, position + y},
-				&(t_vec2){i * tiling + tiling, position + y + texture_y_inc},
-				&color, 1);
-			texture_y += texture_y_inc;
+			cells++;
+			if (master->level.thin_amount > 0)
+			{
+				Sint64 middle_x = horizontal_x - dx / 2;
+				Sint64 middle_y = horizontal_y - dy / 2;
+				int thin = (right ? middle_x > player_x : middle_x < player_x)
+					? cast_thin(master, (int) (middle_x >> FIXED_SHIFT), (int) (middle_y >> FIXED_SHIFT), 2) : -1;
+				if (thin != -1 && cast_hit_fixed(master, thin, middle_x, middle_y, middle_y & (FIXED_ONE - 1), angle, 1,
+					horizontal_layers, &horizontal_amount, &horizontal_texture, &horizontal_offset))
+				{
+					horizontal_x = middle_x;
+					horizontal_y = middle_y;
+					break;
+				}
+			}
+			if (llabs(horizontal_x - player_x) > horizontal_limit)
+			{
+				horizontal_texture = '0';
+				break;
+			}
+			int cell_x = (int) (horizontal_x >> FIXED_SHIFT) + (right ? 0 : -1);
+			if (cell_x < 0)
+				break;
+			int index = level_index(&master->level, cell_x, (int) (horizontal_y >> FIXED_SHIFT));
+			if (level_bit(master->level.wall, index) && cast_hit_fixed(master, index, horizontal_x, horizontal_y, horizontal_y & (FIXED_ONE - 1), angle, 1,
+				horizontal_layers, &horizontal_amount, &horizontal_texture, &horizontal_offset))
+				break;
+			horizontal_x += dx;
+			horizontal_y += dy;
 		}
+		t_fixed horizontal_distance = fixed_distance(master, angle, horizontal_x - player_x, horizontal_y - player_y);
+
+		t_ray *ray = &master->player.rays[i];
+		int vertical = vertical_distance < horizontal_distance;
+		ray->fixed_position.x = (t_fixed) (vertical ? vertical_x : horizontal_x);
+		ray->fixed_position.y = (t_fixed) (vertical ? vertical_y : horizontal_y);
+		ray->fixed_distance = vertical ? vertical_distance : horizontal_distance;
+		ray->fixed_offset = vertical ? vertical_offset : horizontal_offset;
+		ray->fixed_angle = angle;
+		ray->position = (t_vec2){ray->fixed_position.x / (float) FIXED_ONE, ray->fixed_position.y / (float) FIXED_ONE};
+		ray->angle = angle * 2 * PI / FIXED_ANGLES;
+		ray->distance = ray->fixed_distance / (float) FIXED_ONE;
+		ray->offset = ray->fixed_offset / (float) FIXED_ONE;
+		ray->side = vertical ? 0 : 1;
+		ray->texture = vertical ? vertical_texture : horizontal_texture;
+		cast_layers(master, i, 1, vertical_layers, vertical_amount, horizontal_layers, horizontal_amount);
 	}
+	master->telemetry.frame.rays += RAYS_AMOUNT;
+	master->telemetry.frame.cells += cells;
 }
 
 int handle_collisions(t_sdl_master *master, int depth, t_vec2 position, t_vec2 back, t_vec2 direction)
 {
-	for (float off_y = -0.2; off_y <= 0.2; off_y += 0.1)
+	// The box of COLLISION_BOX tenths around the player is narrower than a cell, so its corners and edge
+	// midpoints land in every cell it overlaps; the fixed point path samples the same integer grid.
+	for (int off_y = -COLLISION_BOX; off_y <= COLLISION_BOX; off_y += COLLISION_BOX)
 	{
-		for (float off_x = -0.2; off_x <= 0.2; off_x += 0.1)
+		for (int off_x = -COLLISION_BOX; off_x <= COLLISION_BOX; off_x += COLLISION_BOX)
 		{
-			t_vec2 pos = {position.x + off_x, position.y + off_y};
-			t_texture texture = texture_get(master, master->level.array[(int) pos.y * master->level.width + (int) pos.x]);
-			if (texture.is_solid)
+			t_vec2 pos = {position.x + off_x / 10.0f, position.y + off_y / 10.0f};
+			master->telemetry.frame.collision_samples++;
+			if (level_bit(master->level.solid, level_index(&master->level, (int) pos.x, (int) pos.y)))
 			{
 				if (depth != 0)
 				{
@@ -625,6 +2454,77 @@ void move_player(t_sdl_master *master, float x, float y)
 	}
 }
 
+int handle_collisions_fixed(t_sdl_master *master, int depth, t_fixed_vec2 position, t_fixed_vec2 back, t_fixed_vec2 direction)
+{
+	for (int off_y = -COLLISION_BOX; off_y <= COLLISION_BOX; off_y += COLLISION_BOX)
+	{
+		for (int off_x = -COLLISION_BOX; off_x <= COLLISION_BOX; off_x += COLLISION_BOX)
+		{
+			t_fixed_vec2 pos = {position.x + off_x * FIXED_ONE / 10, position.y + off_y * FIXED_ONE / 10};
+			master->telemetry.frame.collision_samples++;
+			if (level_bit(master->level.solid, level_index(&master->level, pos.x >> FIXED_SHIFT, pos.y >> FIXED_SHIFT)))
+			{
+				if (depth != 0)
+				{
+					return 1;
+				}
+
+				position.x = back.x + direction.x;
+				position.y = back.y;
+
+				if (handle_collisions_fixed(master, depth + 1, position, back, direction) == 0)
+				{
+					master->player.fixed_position = position;
+					return 0;
+				}
+
+				position.x = back.x;
+				position.y = back.y + direction.y;
+
+				if (handle_collisions_fixed(master, depth + 1, position, back, direction) == 0)
+				{
+					master->player.fixed_position = position;
+					return 0;
+				}
+
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+void move_player_fixed(t_sdl_master *master, t_fixed x, t_fixed y)
+{
+	t_fixed_vec2 back = master->player.fixed_position;
+	master->player.fixed_position.x += x;
+	master->player.fixed_position.y += y;
+
+	if (handle_collisions_fixed(master, 0, master->player.fixed_position, back, (t_fixed_vec2){x, y}))
+	{
+		master->player.fixed_position = back;
+	}
+	master->player.position.x = master->player.fixed_position.x / (float) FIXED_ONE;
+	master->player.position.y = master->player.fixed_position.y / (float) FIXED_ONE;
+}
+
+void rotate_player_fixed(t_sdl_master *master, int angle)
+{
+	master->player.fixed_direction = (master->player.fixed_direction + angle + FIXED_ANGLES) % FIXED_ANGLES;
+	master->player.direction = master->player.fixed_direction * 2 * PI / FIXED_ANGLES;
+}
+
+Uint32 screen_hash(t_sdl_canvas *canvas)
+{
+	Uint32 hash = 2166136261u;
+	for (int i = 0; i < canvas->width * canvas->height * 4; i++)
+	{
+		hash = (hash ^ canvas->array[i]) * 16777619u;
+	}
+	return hash;
+}
+
+#ifndef RAYCAST_NO_MAIN
 int main()
 {
 	t_sdl_master master;
@@ -636,6 +2536,7 @@ int main()
 
 	while (1)
 	{
+		Uint64 frame_start = SDL_GetPerformanceCounter();
 		SDL_Event event;
 		if (SDL_PollEvent(&event))
 		{
@@ -643,6 +2544,27 @@ int main()
 			{
 				break;
 			}
+			if (event.type == SDL_KEYDOWN && !event.key.repeat && event.key.keysym.scancode == SDL_SCANCODE_F1)
+			{
+				master.fixed_point = !master.fixed_point;
+				if (master.fixed_point)
+				{
+					fixed_sync(&master);
+					master.stream.synced = 0;
+				}
+			}
+			if (event.type == SDL_KEYDOWN && !event.key.repeat && event.key.keysym.scancode == SDL_SCANCODE_F2)
+			{
+				// Halves casting; drawing is only saved while not moving, see INTERLACE.
+				master.interlace.enabled = !master.interlace.enabled;
+				master.interlace.valid = 0;
+			}
+			if (event.type == SDL_KEYDOWN && !event.key.repeat && event.key.keysym.scancode == SDL_SCANCODE_E)
+			{
+				level_door_toggle(&master,
+					(int) (master.player.position.x + cos(master.player.direction)),
+					(int) (master.player.position.y + sin(master.player.direction)));
+			}
 		}
 
 		SDL_PumpEvents();
@@ -651,95 +2573,66 @@ int main()
 		{
 			break;
 		}
-		if (state[SDL_SCANCODE_UP])
-		{
-			move_player(&master,
-				master.player.speed * cos(master.player.direction),
-				master.player.speed * sin(master.player.direction));
-		}
-		if (state[SDL_SCANCODE_DOWN])
-		{
-			move_player(&master,
-				-master.player.speed * cos(master.player.direction),
-				-master.player.speed * sin(master.player.direction));
-		}
-		if (state[SDL_SCANCODE_LEFT])
+		// Fixed point frames are skipped rather than waited for until the textures are in, see texture_stream_update.
+		texture_stream_update(&master);
+		int drawn = !master.fixed_point || master.stream.synced;
+		if (drawn && master.fixed_point)
 		{
-			master.player.direction -= master.player.rotation_speed;
-		}
-		if (state[SDL_SCANCODE_RIGHT])
-		{
-			master.player.direction += master.player.rotation_speed;
+			if (state[SDL_SCANCODE_UP])
+			{
+				move_player_fixed(&master,
+					(Sint64) master.player.fixed_speed * fixed_cos(&master, master.player.fixed_direction) >> FIXED_SHIFT,
+					(Sint64) master.player.fixed_speed * master.fixed.sin[master.player.fixed_direction] >> FIXED_SHIFT);
+			}
+			if (state[SDL_SCANCODE_DOWN])
+			{
+				move_player_fixed(&master,
+					-((Sint64) master.player.fixed_speed * fixed_cos(&master, master.player.fixed_direction) >> FIXED_SHIFT),
+					-((Sint64) master.player.fixed_speed * master.fixed.sin[master.player.fixed_direction] >> FIXED_SHIFT));
+			}
+			if (state[SDL_SCANCODE_LEFT])
+			{
+				rotate_player_fixed(&master, -master.player.fixed_rotation_speed);
+			}
+			if (state[SDL_SCANCODE_RIGHT])
+			{
+				rotate_player_fixed(&master, master.player.fixed_rotation_speed);
+			}
 		}
-
-		for (int i = 0; i < RAYS_AMOUNT; i++)
+		else if (drawn)
 		{
-			float angle = master.player.direction - RAYS_FOV / 2 + i * RAYS_FOV / RAYS_AMOUNT;
-			while (angle < 0)
-				angle += 2 * PI;
-			while (angle >= 2 * PI)
-				angle -= 2 * PI;
-
-			float dx, dy;
-
-			t_vec2 vertical_position;
-			char vertical_texture;
-			float atan = -1 / tan(angle);
-			vertical_position.y = (int) master.player.position.y + (angle >= PI ? 0 : 1);
-			vertical_position.x = master.player.position.x + (master.player.position.y - vertical_position.y) * atan;
-			dy = (angle >= PI ? -1 : 1);
-			dx = -dy * atan;
-			while (vertical_position.y >= 0 && vertical_position.y < master.level.height)
+			if (state[SDL_SCANCODE_UP])
 			{
-				int index = ((int) (vertical_position.y + (angle >= PI ? -1 : 0))) * master.level.width + (int) (vertical_position.x);
-				if (index < 0 || index >= master.level.width * master.level.height)
-					break;
-				vertical_texture = master.level.array[index];
-				if (texture_get(&master, vertical_texture).size > 0)
-				{
-					break;
-				}
-				vertical_position.y += dy;
-				vertical_position.x += dx;
-			}
-			float vertical_distance = sqrt(pow(vertical_position.x - master.player.position.x, 2) + pow(vertical_position.y - master.player.position.y, 2));
-
-			t_vec2 horizontal_position;
-			char horizontal_texture;
-			float ntan = -tan(angle);
-			horizontal_position.x = (int) master.player.position.x + (angle >= PI / 2 && angle < 3 * PI / 2 ? 0 : 1);
-			horizontal_position.y = master.player.position.y + (master.player.position.x - horizontal_position.x) * ntan;
-			dx = (angle >= PI / 2 && angle < 3 * PI / 2 ? -1 : 1);
-			dy = -dx * ntan;
-			while (horizontal_position.x >= 0 && horizontal_position.x < master.level.width)
-			{
-				int index = ((int) (horizontal_position.y)) * master.level.width + (int) (horizontal_position.x + (angle >= PI / 2 && angle < 3 * PI / 2 ? -1 : 0));
-				if (index < 0 || index >= master.level.width * master.level.height)
-					break;
-				horizontal_texture = master.level.array[index];
-				if (texture_get(&master, horizontal_texture).size > 0)
-				{
-					break;
-				}
-				horizontal_position.x += dx;
-				horizontal_position.y += dy;
+				move_player(&master,
+					master.player.speed * cos(master.player.direction),
+					master.player.speed * sin(master.player.direction));
 			}
-			float horizontal_distance = sqrt(pow(horizontal_position.x - master.player.position.x, 2) + pow(horizontal_position.y - master.player.position.y, 2));
-
-			master.player.rays[i].position = vertical_distance < horizontal_distance ? vertical_position : horizontal_position;
-			master.player.rays[i].angle = angle;
-			master.player.rays[i].distance = vertical_distance < horizontal_distance ? vertical_distance : horizontal_distance;
-			master.player.rays[i].side = vertical_distance < horizontal_distance ? 0 : 1;
-			master.player.rays[i].texture = vertical_distance < horizontal_distance ? vertical_texture : horizontal_texture;
-
-			if (master.player.rays[i].distance < 0.1)
+			if (state[SDL_SCANCODE_DOWN])
 			{
-				break;
+				move_player(&master,
+					-master.player.speed * cos(master.player.direction),
+					-master.player.speed * sin(master.player.direction));
+			}
+			if (state[SDL_SCANCODE_LEFT])
+			{
+				master.player.direction -= master.player.rotation_speed;
+			}
+			if (state[SDL_SCANCODE_RIGHT])
+			{
+				master.player.direction += master.player.rotation_speed;
 			}
 		}
 
-		update_minimap(&master);
-		update_screen(&master);
+		if (drawn)
+		{
+			level_update(&master);
+			if (master.fixed_point)
+				cast_rays_fixed(&master);
+			else
+				cast_rays(&master);
+			update_minimap(&master);
+			update_screen(&master);
+		}
 
 		double t = SDL_GetPerformanceCounter() / 1000000.0;
 		master.fps = 1000 / (t - master.clock);
@@ -747,12 +2640,22 @@ int main()
 		{
 			printf("FPS: %f\n", master.fps);
 		}
+		if (FRAME_HASH && master.fixed_point && drawn)
+		{
+			printf("Frame: %08x\n", screen_hash(&master.screen));
+		}
 
 		master.clock = t;
 		SDL_Delay(1);
+		Uint64 present = SDL_GetPerformanceCounter();
 		update_window(&master);
+		Uint64 end = SDL_GetPerformanceCounter();
+		master.telemetry.frame.present_ns = (end - present) * 1000000000 / SDL_GetPerformanceFrequency();
+		master.telemetry.frame.frame_ns = (end - frame_start) * 1000000000 / SDL_GetPerformanceFrequency();
+		telemetry_publish(&master);
 	}
 	
 	quit(0, &master);
 	return 0;
 }
+#endif
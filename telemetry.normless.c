@@ -0,0 +1,72 @@
+// Live telemetry monitor. Build next to main.normless.c and run while the game is running:
+//   gcc -O2 telemetry.normless.c -o telemetry.normless $(sdl2-config --cflags --libs) -lm
+//   ./telemetry.normless [interval in milliseconds]
+// Every line averages the frames rendered since the previous sample, the game itself is never blocked.
+
+#define RAYCAST_NO_MAIN
+#include "main.normless.c"
+#include <time.h>
+
+int main(int argc, char **argv)
+{
+	int interval = argc > 1 ? atoi(argv[1]) : 1000;
+	if (interval <= 0)
+		interval = 1000;
+
+	int fd = shm_open(TELEMETRY_NAME, O_RDONLY, 0);
+	if (fd == -1)
+	{
+		printf("shm_open Error. (is the game running?)\n");
+		return 1;
+	}
+	t_telemetry_block *shared = mmap(NULL, sizeof(t_telemetry_block), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shared == MAP_FAILED)
+	{
+		printf("mmap Error.\n");
+		return 1;
+	}
+	if (shared->version != TELEMETRY_VERSION)
+	{
+		printf("Telemetry version Error. (expected %d, found %u)\n", TELEMETRY_VERSION, shared->version);
+		return 1;
+	}
+
+	t_counters last, total, previous;
+	if (telemetry_read(shared, &last, &previous) != 0)
+	{
+		printf("Telemetry read Error.\n");
+		return 1;
+	}
+	printf("%8s %7s %9s %9s %9s %11s %11s %10s %9s %9s\n", "frame", "fps", "frame ms", "present", "cells/ray",
+		"wall px", "surface px", "texels", "collide", "lookups");
+	while (1)
+	{
+		nanosleep(&(struct timespec){interval / 1000, interval % 1000 * 1000000L}, NULL);
+		if (telemetry_read(shared, &last, &total) != 0)
+			continue;
+		Uint64 frames = total.frame - previous.frame;
+		if (frames == 0)
+		{
+			printf("%8llu (no new frames)\n", (unsigned long long) total.frame);
+			fflush(stdout);
+			continue;
+		}
+		double frame_ns = (double) (total.frame_ns - previous.frame_ns) / frames;
+		Uint64 rays = total.rays - previous.rays;
+		printf("%8llu %7.1f %9.3f %9.3f %9.2f %11.0f %11.0f %10.0f %9.1f %9.1f\n",
+			(unsigned long long) total.frame,
+			frame_ns > 0 ? 1000000000.0 / frame_ns : 0,
+			frame_ns / 1000000.0,
+			(double) (total.present_ns - previous.present_ns) / frames / 1000000.0,
+			rays > 0 ? (double) (total.cells - previous.cells) / rays : 0,
+			(double) (total.wall_pixels - previous.wall_pixels) / frames,
+			(double) (total.surface_pixels - previous.surface_pixels) / frames,
+			(double) (total.texels - previous.texels) / frames,
+			(double) (total.collision_samples - previous.collision_samples) / frames,
+			(double) (total.texture_lookups - previous.texture_lookups) / frames);
+		fflush(stdout);
+		previous = total;
+	}
+	return 0;
+}